@@ -0,0 +1,26 @@
+#include <neo.h>
+#include <iostream>
+#include <chrono>
+#include <thread>
+
+
+using namespace std; 
+
+int main() {
+	neo::Gpio button(12);
+
+	//Only the validated presses and releases of the button get here
+	button.attachInterrupt("both", [](int pin, int data) {
+		cout << "P: " << pin << (data ? " released" : " pressed") << endl;
+	});
+
+	//Ignore pulses shorter than 2ms and report nothing for 20ms after a transition
+	button.setDebounce(20000000ULL, 2000000ULL);
+
+	while(1) {
+		this_thread::sleep_for(chrono::seconds(5));
+		cout << "Bounces thrown away: " << button.getSuppressed() << endl;
+	}
+
+	return 0;
+}
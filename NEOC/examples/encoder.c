@@ -0,0 +1,27 @@
+#include <neo.h>
+#include <stdio.h>
+#include <unistd.h>
+
+
+int main() {
+	neo_gpio_init(); //Start gpio
+
+	//Channel A on pin 12 and B on pin 13, count every edge of both
+	int enc = neo_encoder_init(12, 13, NEO_ENCODER_X4);
+
+	if(enc < NEO_OK) {
+		printf("Failed starting the encoder on pins 12 and 13\n");
+		return 1;
+	}
+
+	while(1) {
+		printf("Position: %lld Velocity: %.1f steps/s\n", (long long) neo_encoder_position(enc), neo_encoder_velocity(enc));
+
+		//Turn it back to 0 past a full turn of a 600 step encoder
+		if(neo_encoder_position(enc) >= 2400) neo_encoder_reset(enc);
+		usleep(1000 * 200);
+	}
+
+	neo_encoder_free(enc);
+	return 0;
+}
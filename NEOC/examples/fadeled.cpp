@@ -7,20 +7,16 @@ using namespace std;
 
 int main() {
 	neo::FakePWM pwm(13);
-	pwm.setPeriod(20408);
+	pwm.setPeriod(2040); //Micro seconds, ~490Hz
 
 	while(1) {
-		//Fade up to 255
-		for(int i = 0; i < 255; i++) {
-			pwm.write(i); //Write up pwm value
-			this_thread::sleep_for(chrono::milliseconds(10));
-		}
+		//Fade up to 255 in the background (one thread runs every fade)
+		pwm.ramp(255, 2550000000ULL, NEO_RAMP_GAMMA);
+		while(pwm.ramping()) this_thread::sleep_for(chrono::milliseconds(10));
 
 		//Fade down back to 0
-		for(int d = 255; d > 0; d--) {
-			pwm.write(d); //Write down pwm value
-			this_thread::sleep_for(chrono::milliseconds(10));
-		}
+		pwm.ramp(0, 2550000000ULL, NEO_RAMP_GAMMA);
+		while(pwm.ramping()) this_thread::sleep_for(chrono::milliseconds(10));
 		this_thread::sleep_for(chrono::milliseconds(400));
 	}
 
@@ -0,0 +1,42 @@
+#include <neo.h>
+#include <stdio.h>
+
+#define STEPS 2000
+
+
+int main() {
+	static neo_seq_step_t steps[STEPS];
+	neo_seq_stats_t stats;
+	int i, ret;
+
+	//The register backend writes the pins in a fraction of a microsecond
+	if(neo_gpio_init_backend(NEO_GPIO_MMAP) != NEO_OK) {
+		printf("Failed starting the memory mapped gpio\n");
+		return 1;
+	}
+	neo_gpio_pin_mode(12, OUTPUT);
+	neo_gpio_pin_mode(13, OUTPUT);
+
+	//A 1KHz square wave on pin 12 and half of it on pin 13, every 500us for one second
+	for(i = 0; i < STEPS; i++) {
+		steps[i].t_ns = i * 500000ULL;
+		steps[i].mask = (1ULL << 12) | (1ULL << 13);
+		steps[i].values = ((i & 1) ? (1ULL << 12) : 0) | ((i & 2) ? (1ULL << 13) : 0);
+	}
+
+	//Busy wait the last 50us before each step
+	ret = neo_seq_start(steps, STEPS, 50000, NULL);
+	if(ret != NEO_OK) {
+		printf("Failed starting the waveform: %d\n", ret);
+		return 1;
+	}
+	neo_seq_wait(&stats);
+
+	if(stats.error != NEO_OK) printf("Stopped on step %llu: %d\n", (unsigned long long) stats.steps, stats.error);
+	printf("Played %llu steps, late min %lldns max %lldns avg %lldns (%llu over 10us) realtime: %d\n",
+			(unsigned long long) stats.steps, (long long) stats.late_min_ns, (long long) stats.late_max_ns,
+			(long long) stats.late_avg_ns, (unsigned long long) stats.late_over, stats.realtime);
+
+	neo_gpio_free();
+	return 0;
+}
@@ -0,0 +1,32 @@
+#include <neo.h>
+#include <stdio.h>
+#include <unistd.h>
+
+
+int main() {
+	uint64_t dropped = 0;
+	int i;
+
+	neo_gpio_init(); //Start gpio
+	neo_gpio_pin_mode(13, OUTPUT);
+
+	//Inputs are recorded from the interrupt engine, so attach pin 12 (NULL only queues the edges)
+	neo_gpio_attach_interrupt(12, "both", NULL);
+
+	if(neo_vcd_start("gpio.vcd", (1ULL << 12) | (1ULL << 13)) != NEO_OK) {
+		printf("Failed starting the recording\n");
+		return 1;
+	}
+
+	//Blink pin 13 for a second, wire it to pin 12 to see both
+	for(i = 0; i < 20; i++) {
+		neo_gpio_digital_write(13, i & 1);
+		usleep(1000 * 50);
+	}
+
+	neo_vcd_stop(&dropped);
+	printf("Wrote gpio.vcd (%llu changes dropped), open it with GTKWave\n", (unsigned long long) dropped);
+
+	neo_gpio_free();
+	return 0;
+}
@@ -182,12 +182,86 @@
 #ifndef NEOC_H
 #define NEOC_H
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 typedef void (*interruptfunc)(int, int);
 
+/**
+ * @brief A timestamped edge of an attached gpio pin @see neo_gpio_poll_events()
+ */
+typedef struct neo_gpio_event_h {
+	int pin; ///< The pin that changed
+	int value; ///< The state of the pin after the edge (HIGH/LOW)
+	uint64_t timestamp_ns; ///< CLOCK_MONOTONIC time of the edge in nanoseconds
+	uint64_t seq; ///< Sequence number of the edge, a gap means events were dropped
+} neo_gpio_event_t;
+
+/**
+ * @brief One step of a gpio waveform @see neo_seq_start()
+ */
+typedef struct neo_seq_step_h {
+	uint64_t t_ns; ///< When to write the pins, in nanoseconds after the start
+	uint64_t mask; ///< The pins to write (bit n is gpio pin n)
+	uint64_t values; ///< The values to write to those pins
+} neo_seq_step_t;
+
+/**
+ * @brief How late the steps of a gpio waveform were played @see neo_seq_wait()
+ */
+typedef struct neo_seq_stats_h {
+	uint64_t steps; ///< The amount of steps played
+	uint64_t start_ns; ///< CLOCK_MONOTONIC time of t_ns 0
+	int64_t late_min_ns; ///< The least late step
+	int64_t late_max_ns; ///< The most late step
+	int64_t late_avg_ns; ///< The average lateness
+	uint64_t late_over; ///< The amount of steps more than 10us late
+	int realtime; ///< If the thread got SCHED_FIFO
+	int error; ///< NEO_OK, or the error of the write that stopped the waveform (the step at index steps)
+} neo_seq_stats_t;
+
+/**
+ * @brief What and how to sample with the logic analyzer @see neo_analyzer_start()
+ */
+typedef struct neo_analyzer_config_h {
+	uint64_t pins; ///< The pins to sample (bit n is gpio pin n)
+	unsigned int rate_hz; ///< Samples per second (1 - 200000)
+	int trigger; ///< NEO_TRIGGER_NONE, NEO_TRIGGER_PATTERN, NEO_TRIGGER_RISING, NEO_TRIGGER_FALLING or NEO_TRIGGER_EDGE
+	uint64_t trigger_mask; ///< The pins the trigger looks at
+	uint64_t trigger_value; ///< The values of those pins for NEO_TRIGGER_PATTERN
+	int pre; ///< How many samples to keep from before the trigger
+	int cpu; ///< The cpu to pin the sampling thread to (-1 for any)
+} neo_analyzer_config_t;
+
+/**
+ * @brief Where the samples of a finished capture are in the ring @see neo_analyzer_wait()
+ */
+typedef struct neo_analyzer_result_h {
+	int first; ///< Index in the buffer of the oldest sample
+	int count; ///< The amount of samples kept
+	int trigger; ///< The trigger sample counted from the oldest (-1 if not triggered)
+	uint64_t start_ns; ///< CLOCK_MONOTONIC time of the oldest sample
+	uint64_t period_ns; ///< Time between two samples
+	uint64_t samples; ///< Samples taken in total (the older ones were overwritten)
+	uint64_t missed; ///< Ticks the thread was late for, they repeat the sample before and have NEO_LA_REPEATED set
+} neo_analyzer_result_t;
+
+/**
+ * @brief How well a fake pwm channel keeps it's timing @see neo_fake_pwm_stats()
+ */
+typedef struct neo_pwm_stats_h {
+	double freq_hz; ///< The average measured frequency in Hertz
+	double duty; ///< The average measured duty cycle (0 - 1)
+	double duty_error; ///< The measured duty cycle minus the requested one
+	uint64_t jitter_max_ns; ///< The farthest a toggle landed from it's deadline
+	uint64_t jitter_avg_ns; ///< The average distance of the toggles from their deadlines
+	uint64_t periods; ///< The amount of periods measured
+	int realtime; ///< If the thread manager got SCHED_FIFO
+} neo_pwm_stats_t;
+
 #ifndef DOXYGEN_SKIP
 
 #define GPIOPORTSL 48
@@ -202,6 +276,52 @@ typedef void (*interruptfunc)(int, int);
 #define EDGEPATH "/edge"
 #define ACTIVELOWPATH "/active_low"
 
+#define GPIOCHIPPATH "/dev/gpiochip%d"
+#define GPIOCONSUMER "libneo"
+#define GPIOBANKL 7
+#define GPIOBANKSIZE 32
+
+#define GPIOMMAPPATH "/dev/mem"
+#define GPIOMMAPBASE 0x0209C000
+#define GPIOMMAPSTRIDE 0x4000
+#define GPIOREGDR 0x00
+#define GPIOREGGDIR 0x04
+#define GPIOREGPSR 0x08
+
+#define INTEVENTSL 16
+#define INTRINGL 1024
+#define CAPTUREL 64
+#define ENCODERSL 8
+#define ENCODERVELNS 20000000ULL
+#define ENCODERIDLENS 250000000ULL
+
+#define SEQPRIORITY 80
+#define SEQLEADNS 200000ULL
+#define SEQSLICENS 10000000ULL
+#define SEQLATENS 10000
+#define SEQMAXSPINNS 1000000ULL
+
+#define LAPRIORITY 70
+#define LAMAXHZ 200000
+#define LASPINNS 50000ULL
+#define LABUSYNS 10000000ULL
+#define LARESTNS 100000ULL
+#define INTWAKEID 0xFFFF
+#define INTTIMERID 0xFFFE
+#define INTEDGENONE 0
+#define INTEDGERISING 1
+#define INTEDGEFALLING 2
+#define INTEDGEBOTH 3
+
+#define RAMPLUTL 1024
+#define RAMPTICKNS 5000000ULL
+#define RAMPSLOTSL (PWMPORTSL + GPIOPORTSL)
+
+#define VCDRINGL 8192
+#define VCDBUFL 65536
+#define VCDTICKNS 5000000
+#define VCDID(pin) ((char) ('!' + (pin)))
+
 #define NOEDGE "none"
 #define FALLINGEDGE "falling"
 #define RISINGEDGE "rising"
@@ -212,9 +332,16 @@ typedef void (*interruptfunc)(int, int);
 #define PWMPERIOD "/period"
 #define PWMDUTY "/duty_cycle"
 #define PWMENABLE "/enable"
+#define PWMPOLARITY "/polarity"
+
+#define PWMOPENTRIES 50
+#define PWMOPENWAITUS 2000
 
 #define MAXFAKEPWM 47
-#define PWMMUTEXRATE 0.00010f
+#define FAKEPWMPERIOD 2040
+#define PWMPRIORITY 60
+#define PWMSLICENS 10000000ULL
+#define PWMLEADNS 200000
 
 #define ANALOGPATHP "/sys/bus/iio/devices/iio\:device"
 #define ANALOGBASEP ((const char *) "/in_voltage")
@@ -290,6 +417,12 @@ typedef void (*interruptfunc)(int, int);
 ///@brief When the i2c line failed to read from the register
 #define NEO_I2C_READ_ERROR -17
 
+///@brief When a wait ran out of time before anything happened
+#define NEO_TIMEOUT_ERROR -18
+
+///@brief When the kernel refused to write a gpio pin
+#define NEO_WRITE_ERROR -19
+
 
 #ifndef DOXYGEN_SKIP
 
@@ -329,6 +462,75 @@ typedef void (*interruptfunc)(int, int);
 ///@brief To set the GPIO or anything pin to state LOW aka off
 #define LOW 0
 
+///@brief Gpio backend using the legacy sysfs files (default of neo_gpio_init)
+#define NEO_GPIO_SYSFS 0
+
+///@brief Gpio backend using the gpiochip character device line requests
+#define NEO_GPIO_CHARDEV 1
+
+///@brief Gpio backend writing the i.MX6 gpio bank registers directly through mmap
+#define NEO_GPIO_MMAP 2
+
+///@brief Flag to add to a gpio backend to only open the pins on their first use
+#define NEO_GPIO_LAZY 0x10
+
+///@brief Logic analyzer trigger that starts right away
+#define NEO_TRIGGER_NONE 0
+
+///@brief Logic analyzer trigger on the trigger pins matching a pattern
+#define NEO_TRIGGER_PATTERN 1
+
+///@brief Logic analyzer trigger on any trigger pin going from 0 to 1
+#define NEO_TRIGGER_RISING 2
+
+///@brief Logic analyzer trigger on any trigger pin going from 1 to 0
+#define NEO_TRIGGER_FALLING 3
+
+///@brief Logic analyzer trigger on any trigger pin changing
+#define NEO_TRIGGER_EDGE 4
+
+///@brief Bit set on a logic analyzer sample the thread was too late for, it repeats the sample before
+#define NEO_LA_REPEATED (1ULL << 63)
+
+///@brief Fake pwm group with every channel starting it's period at the same time
+#define NEO_PWM_ALIGNED 0
+
+///@brief Fake pwm group with the period starts spread evenly over the period
+#define NEO_PWM_STAGGERED 1
+
+///@brief Fake pwm pair with the second pin driven as the inverse of the first with dead time
+#define NEO_PWM_COMPLEMENTARY 2
+
+///@brief Ramp of a real pwm pin @see neo_pwm_ramp()
+#define NEO_RAMP_PWM 0
+
+///@brief Ramp of a fake pwm gpio pin @see neo_pwm_ramp()
+#define NEO_RAMP_FAKE_PWM 1
+
+///@brief Ramp moving the duty cycle evenly
+#define NEO_RAMP_LINEAR 0
+
+///@brief Ramp moving the perceived brightness evenly (gamma 2.2)
+#define NEO_RAMP_GAMMA 1
+
+///@brief Ramp starting slow
+#define NEO_RAMP_EASE_IN 2
+
+///@brief Ramp ending slow
+#define NEO_RAMP_EASE_OUT 3
+
+///@brief Ramp starting and ending slow
+#define NEO_RAMP_EASE_IN_OUT 4
+
+///@brief Quadrature encoder counting the rising edges of A
+#define NEO_ENCODER_X1 1
+
+///@brief Quadrature encoder counting both edges of A
+#define NEO_ENCODER_X2 2
+
+///@brief Quadrature encoder counting both edges of A and B
+#define NEO_ENCODER_X4 4
+
 #ifndef DOXYGEN_SKIP
 
 #include <string.h>
@@ -353,6 +555,14 @@ typedef void (*interruptfunc)(int, int);
 
 extern const char * const GPIOPORTS[];
 extern unsigned char USABLEGPIO[];
+extern unsigned char DIRGPIO[];
+extern int GPIOBANK[];
+extern int GPIOLINE[];
+extern int neo_gpio_backend;
+
+//Atomic access to the gpio shadow state that every thread shares
+#define GPIOGET(arr, pin) __atomic_load_n(&(arr)[pin], __ATOMIC_ACQUIRE)
+#define GPIOSET(arr, pin, val) __atomic_store_n(&(arr)[pin], (unsigned char) (val), __ATOMIC_RELEASE)
 extern unsigned char PWMPORTS[];
 extern unsigned char USABLEPWM[];
 extern const char * const ANALOGPORTS[][2];
@@ -374,31 +584,90 @@ int neo_screen_set_hdmi();
 //extern unsigned int neo_pwm_duty = 50;
 
 int neo_gpio_init();
+int neo_gpio_init_backend(int);
+int neo_gpio_set_mmap_source(const char*, unsigned long);
 int neo_gpio_pin_mode(int, int);
 int neo_gpio_attach_interrupt(int, const char*, interruptfunc);
+int neo_gpio_set_interrupt_mode(int, const char*);
+int neo_gpio_detach_interrupt(int);
+int neo_gpio_poll_events(neo_gpio_event_t*, int);
+int neo_gpio_wait_edge(int, const char*, int64_t, uint64_t*);
+int neo_gpio_set_debounce(int, uint64_t, uint64_t);
+int neo_gpio_debounce_suppressed(int, uint64_t*);
+int neo_gpio_set_capture(int, int);
+int neo_gpio_capture_stats(int, double*, uint64_t*, uint64_t*);
+int neo_gpio_set_cached(int, int);
+int neo_gpio_set_counter(int, const char*);
+int neo_gpio_count_read_and_reset(int, uint64_t*);
 int neo_gpio_digital_write(int, int);
 int neo_gpio_digital_read(int);
+int neo_gpio_write_mask(uint64_t, uint64_t);
+int neo_gpio_read_all(uint64_t*);
 int neo_gpio_free();
 
+int neo_encoder_init(int, int, int);
+int neo_encoder_free(int);
+int64_t neo_encoder_position(int);
+double neo_encoder_velocity(int);
+int neo_encoder_reset(int);
+
+int neo_seq_start(const neo_seq_step_t*, int, uint64_t, int64_t*);
+int neo_seq_wait(neo_seq_stats_t*);
+int neo_seq_stop(neo_seq_stats_t*);
+
+int neo_analyzer_start(const neo_analyzer_config_t*, uint64_t*, int);
+int neo_analyzer_wait(neo_analyzer_result_t*);
+int neo_analyzer_stop(neo_analyzer_result_t*);
+
+int neo_vcd_start(const char*, uint64_t);
+int neo_vcd_stop(uint64_t*);
+
 int neo_pwm_init();
 
 #ifndef DOXYGEN_SKIP
 
 int neo_gpio_digital_write_no_safety(int*, int);
-
-void neo_sync_pwm(void*, int*, int*, int*, int*);
+int __neo_gpio_ready(int);
+int __neo_gpio_get_value(int);
+int __neo_gpio_sample(uint64_t, uint64_t*);
+int __neo_gpio_set_edge(int, const char*);
+int __neo_gpio_edge_fd(int);
+void __neo_initialize_interrupts();
+void __neo_encoder_edge(int, int, uint64_t);
+void __neo_encoder_free_all();
+int __neo_interrupt_cached(int);
+void __neo_vcd_record(int, int, uint64_t);
+uint64_t __neo_vcd_stamp();
+void __neo_interrupt_stop();
+void __neo_interrupt_free();
+
+struct pwm_timing_h;
+void neo_sync_pwm(void*, int*, struct pwm_timing_h*);
 void *pwmManager(void*);
+void __neo_fake_pwm_free();
+int __neo_fake_pwm_duty(int);
+int __neo_pwm_duty(int);
+void __neo_ramp_free(int);
 
 #endif
 
 int neo_fake_pwm_init();
 int neo_fake_pwm_write_period(int, int, int);
 int neo_fake_pwm_write(int, int);
+int neo_fake_pwm_stats(int, neo_pwm_stats_t*, int);
+int neo_fake_pwm_group(const int*, int, int, int, int);
+int neo_fake_pwm_set_period(int, int);
+int neo_fake_pwm_set_polarity(int, int);
 int neo_pwm_set_period(int, int);
+int neo_pwm_set_polarity(int, int);
 int neo_pwm_set_period_all(int);
 int neo_pwm_write(int, int);
 int neo_pwm_free();
 
+int neo_pwm_ramp(int, int, int, uint64_t, int);
+int neo_pwm_ramp_stop(int, int);
+int neo_pwm_ramp_busy(int, int);
+
 int neo_analog_init();
 float neo_analog_read(int);
 float neo_analog_read_raw(int);
@@ -481,6 +750,7 @@ void neo_free_all();
 #include <string>
 #include <cstring>
 #include <iostream>
+#include <initializer_list>
 
 namespace neo {
 
@@ -803,6 +1073,24 @@ class Gpio {
 			return ret == NEO_OK;
 		}
 
+		/**
+		 * @brief Static initializer with a selected backend
+		 *
+		 * A functions that wraps the C neo_gpio_init_backend function. Call this before
+		 * creating any Gpio objects, since they initialize the default (sysfs) backend
+		 *
+		 * @param backend Either NEO_GPIO_SYSFS, NEO_GPIO_CHARDEV or NEO_GPIO_MMAP (optionally | NEO_GPIO_LAZY)
+		 * @param throws A boolean to indicate if the object should throw an error when it fails
+		 *
+		 */
+		static bool initBackend(int backend, bool throws = false) {
+			int ret = neo_gpio_init_backend(backend);
+			if(throws && ret != NEO_OK) {
+				neo::error::Handler(ret, -1, 0, GPIOPORTSL, 0, "Gpio", "Failed to Init");
+			}
+			return ret == NEO_OK;
+		}
+
 		/**
 		 * @brief Static de-initializer
 		 *
@@ -925,17 +1213,17 @@ class Gpio {
 		/**
 		 * @brief Static attaching an interrupt
 		 *
-		 * This will start a new thread that listens for a pin change state based on what you want
+		 * This will have the shared dispatcher thread listen for a pin change state based on what you want
 		 * A state of either "rising" to only detect when the pin changes from 0 to 1. "falling" for the
 		 * function to only call from 1 to 0 and "both" that happens if it changes either way.
 		 *
 		 * @return A boolean if the operation succeded or not
 		 * @param port The port to attach interrupt too
 		 * @param mode The mode to put the pin in available ("both", "rising", "falling")
-		 * @param intfunc The function pointer or lambda to the interrupt return
+		 * @param intfunc The function pointer or lambda to the interrupt return (NULL to only queue the edges)
 		 * @param throws Optional value to throw if there is an error (default: true)
 		 *
-		 * @warning You cannot currently detach the pin as soon as you attach
+		 * @note Attaching again only changes the mode and the function @see detachInterrupt()
 		 */
 		static bool attachInterrupt(int port, const char * mode, interruptfunc intfunc, bool throws = true) {
 			int ret = neo_gpio_attach_interrupt(port, mode, intfunc);
@@ -948,7 +1236,7 @@ class Gpio {
 		/**
 		 * @brief Attaching an interrupt to the current pin
 		 *
-		 * This will start a new thread that listens for a pin change state based on what you want
+		 * This will have the shared dispatcher thread listen for a pin change state based on what you want
 		 * A state of either "rising" to only detect when the pin changes from 0 to 1. "falling" for the
 		 * function to only call from 1 to 0 and "both" that happens if it changes either way.
 		 *
@@ -956,12 +1244,254 @@ class Gpio {
 		 * @param mode The mode to put the pin in available ("both", "rising", "falling")
 		 * @param intfunc The function pointer or lambda to the interrupt return
 		 *
-		 * @warning You cannot currently detach the pin as soon as you attach
+		 * @note Attaching again only changes the mode and the function @see detachInterrupt()
 		 */
 		bool attachInterrupt(const char * mode, interruptfunc intfunc) {
 			return Gpio::attachInterrupt(_held, mode, intfunc, _throwing);
 		}
 		
+		/**
+		 * @brief Static changing of the edge an attached interrupt listens for
+		 *
+		 * @return A boolean if the operation succeded or not
+		 * @param port The attached port
+		 * @param mode The new mode available ("both", "rising", "falling")
+		 * @param throws Optional value to throw if there is an error (default: true)
+		 */
+		static bool setInterruptMode(int port, const char * mode, bool throws = true) {
+			int ret = neo_gpio_set_interrupt_mode(port, mode);
+			if(throws && ret != NEO_OK) {
+				neo::error::Handler(ret, port, 0, GPIOPORTSL, 0, "Gpio", "Failed to change interrupt mode of Gpio Pin");
+			}
+			return ret == NEO_OK;
+		}
+		
+		/**
+		 * @brief Changing the edge the interrupt of the current pin listens for
+		 *
+		 * @return A boolean if the operation succeded
+		 * @param mode The new mode available ("both", "rising", "falling")
+		 */
+		bool setInterruptMode(const char * mode) {
+			return Gpio::setInterruptMode(_held, mode, _throwing);
+		}
+		
+		/**
+		 * @brief Static detaching of a pin interrupt
+		 *
+		 * @return A boolean if the operation succeded or not
+		 * @param port The port to detach
+		 * @param throws Optional value to throw if there is an error (default: true)
+		 */
+		static bool detachInterrupt(int port, bool throws = true) {
+			int ret = neo_gpio_detach_interrupt(port);
+			if(throws && ret != NEO_OK) {
+				neo::error::Handler(ret, port, 0, GPIOPORTSL, 0, "Gpio", "Failed to detach Gpio Pin");
+			}
+			return ret == NEO_OK;
+		}
+		
+		/**
+		 * @brief Detaching the interrupt of the current pin
+		 *
+		 * @return A boolean if the operation succeded
+		 */
+		bool detachInterrupt() {
+			return Gpio::detachInterrupt(_held, _throwing);
+		}
+		
+		/**
+		 * @brief Static waiting for an edge on a pin
+		 *
+		 * Blocks the calling thread until the pin changes the way you want or the time runs out
+		 * @see neo_gpio_wait_edge()
+		 *
+		 * @return True on the edge and false if the time ran out
+		 * @param port The port to wait on
+		 * @param mode The edge to wait for ("both", "rising", "falling")
+		 * @param timeout_ns How long to wait in nanoseconds (negative waits forever)
+		 * @param ts Optional place to store the CLOCK_MONOTONIC time of the edge
+		 * @param throws Optional value to throw if there is an error (default: true)
+		 */
+		static bool waitEdge(int port, const char * mode, int64_t timeout_ns, uint64_t *ts = NULL, bool throws = true) {
+			int ret = neo_gpio_wait_edge(port, mode, timeout_ns, ts);
+			if(throws && ret != NEO_OK) {
+				neo::error::Handler(ret, port, 0, GPIOPORTSL, 0, "Gpio", "Failed to wait for edge on Gpio Pin");
+			}
+			return ret == NEO_OK;
+		}
+		
+		/**
+		 * @brief Waiting for an edge on the current pin
+		 *
+		 * @return True on the edge and false if the time ran out
+		 * @param mode The edge to wait for ("both", "rising", "falling")
+		 * @param timeout_ns How long to wait in nanoseconds (negative waits forever)
+		 * @param ts Optional place to store the CLOCK_MONOTONIC time of the edge
+		 */
+		bool waitEdge(const char * mode, int64_t timeout_ns, uint64_t *ts = NULL) {
+			return Gpio::waitEdge(_held, mode, timeout_ns, ts, _throwing);
+		}
+		
+		/**
+		 * @brief Static debouncing of a pin interrupt
+		 *
+		 * Filters the edges in the interrupt dispatcher so only validated transitions are reported
+		 * @see neo_gpio_set_debounce()
+		 *
+		 * @return A boolean if the operation succeded or not
+		 * @param port The port to debounce
+		 * @param stable_ns The lock out after a reported transition in nanoseconds
+		 * @param glitch_ns The minimum width of a pulse in nanoseconds
+		 * @param throws Optional value to throw if there is an error (default: true)
+		 */
+		static bool setDebounce(int port, uint64_t stable_ns, uint64_t glitch_ns, bool throws = true) {
+			int ret = neo_gpio_set_debounce(port, stable_ns, glitch_ns);
+			if(throws && ret != NEO_OK) {
+				neo::error::Handler(ret, port, 0, GPIOPORTSL, 0, "Gpio", "Failed to debounce Gpio Pin");
+			}
+			return ret == NEO_OK;
+		}
+		
+		/**
+		 * @brief Debouncing the interrupt of the current pin
+		 *
+		 * @return A boolean if the operation succeded
+		 * @param stable_ns The lock out after a reported transition in nanoseconds
+		 * @param glitch_ns The minimum width of a pulse in nanoseconds
+		 */
+		bool setDebounce(uint64_t stable_ns, uint64_t glitch_ns) {
+			return Gpio::setDebounce(_held, stable_ns, glitch_ns, _throwing);
+		}
+		
+		/**
+		 * @brief Getting how many edges the debounce of the current pin threw away
+		 *
+		 * @return The amount of suppressed edges @see neo_gpio_debounce_suppressed()
+		 */
+		uint64_t getSuppressed() {
+			uint64_t count = 0;
+			neo_gpio_debounce_suppressed(_held, &count);
+			return count;
+		}
+		
+		/**
+		 * @brief Static turning on or off the pulse capture of a pin
+		 *
+		 * @return A boolean if the operation succeded or not
+		 * @param port The port to capture
+		 * @param window The amount of pulses to average (1 - 64), 0 to turn the capture off
+		 * @param throws Optional value to throw if there is an error (default: true)
+		 */
+		static bool setCapture(int port, int window, bool throws = true) {
+			int ret = neo_gpio_set_capture(port, window);
+			if(throws && ret != NEO_OK) {
+				neo::error::Handler(ret, port, 0, GPIOPORTSL, 0, "Gpio", "Failed to capture Gpio Pin");
+			}
+			return ret == NEO_OK;
+		}
+		
+		/**
+		 * @brief Turning on or off the pulse capture of the current pin
+		 *
+		 * @return A boolean if the operation succeded
+		 * @param window The amount of pulses to average (1 - 64), 0 to turn the capture off
+		 */
+		bool setCapture(int window) {
+			return Gpio::setCapture(_held, window, _throwing);
+		}
+		
+		/**
+		 * @brief Getting the frequency and pulse widths measured on the current pin
+		 *
+		 * @return True if a full period was measured @see neo_gpio_capture_stats()
+		 * @param freq_hz Where to store the frequency in Hertz
+		 * @param high_ns Optional place to store the average high pulse in nanoseconds
+		 * @param low_ns Optional place to store the average low pulse in nanoseconds
+		 */
+		bool captureStats(double *freq_hz, uint64_t *high_ns = NULL, uint64_t *low_ns = NULL) {
+			return neo_gpio_capture_stats(_held, freq_hz, high_ns, low_ns) == NEO_OK;
+		}
+		
+		/**
+		 * @brief Static turning on or off the cached reads of a pin
+		 *
+		 * @return A boolean if the operation succeded or not
+		 * @param port The port to cache
+		 * @param enable True to read the pin from the interrupt dispatcher @see neo_gpio_set_cached()
+		 * @param throws Optional value to throw if there is an error (default: true)
+		 */
+		static bool setCached(int port, bool enable, bool throws = true) {
+			int ret = neo_gpio_set_cached(port, (enable) ? 1 : 0);
+			if(throws && ret != NEO_OK) {
+				neo::error::Handler(ret, port, 0, GPIOPORTSL, 0, "Gpio", "Failed to cache Gpio Pin");
+			}
+			return ret == NEO_OK;
+		}
+		
+		/**
+		 * @brief Turning on or off the cached reads of the current pin
+		 *
+		 * @return A boolean if the operation succeded
+		 * @param enable True to read the pin from the interrupt dispatcher
+		 */
+		bool setCached(bool enable) {
+			return Gpio::setCached(_held, enable, _throwing);
+		}
+		
+		/**
+		 * @brief Static turning on or off the edge counter of a pin
+		 *
+		 * @return A boolean if the operation succeded or not
+		 * @param port The port to count
+		 * @param mode The edges to count ("both", "rising", "falling") or "none" to stop @see neo_gpio_set_counter()
+		 * @param throws Optional value to throw if there is an error (default: true)
+		 */
+		static bool setCounter(int port, const char *mode, bool throws = true) {
+			int ret = neo_gpio_set_counter(port, mode);
+			if(throws && ret != NEO_OK) {
+				neo::error::Handler(ret, port, 0, GPIOPORTSL, 0, "Gpio", "Failed to count Gpio Pin");
+			}
+			return ret == NEO_OK;
+		}
+		
+		/**
+		 * @brief Turning on or off the edge counter of the current pin
+		 *
+		 * @return A boolean if the operation succeded
+		 * @param mode The edges to count ("both", "rising", "falling") or "none" to stop
+		 */
+		bool setCounter(const char *mode) {
+			return Gpio::setCounter(_held, mode, _throwing);
+		}
+		
+		/**
+		 * @brief Reading the edge counter of the current pin and setting it back to 0
+		 *
+		 * @return The amount of edges since the last read @see neo_gpio_count_read_and_reset()
+		 */
+		uint64_t countReadAndReset() {
+			uint64_t count = 0;
+			neo_gpio_count_read_and_reset(_held, &count);
+			return count;
+		}
+		
+		/**
+		 * @brief Static draining of the queued interrupt edges
+		 *
+		 * Copies the oldest timestamped edges of every attached pin in order @see neo_gpio_poll_events()
+		 *
+		 * @return The amount of events copied (0 if none are queued)
+		 * @param buf The array to copy the events into
+		 * @param n The size of the array
+		 *
+		 * @warning Only call this from one thread at a time
+		 */
+		static int pollEvents(neo_gpio_event_t *buf, int n) {
+			int ret = neo_gpio_poll_events(buf, n);
+			return (ret < 0) ? 0 : ret;
+		}
+		
 		
 		
 		/**
@@ -1012,6 +1542,270 @@ class Gpio {
 short Gpio::_in_use = 0; //Set no object counts
 bool Gpio::_release = false; //Set to automatically release
 
+/** @class PinGroup neo.h
+ * @brief A group of Gpio pins written together as one parallel bus
+ * 
+ * This class drives a set of gpio pins as if they were a single port, the first
+ * pin in the group is bit 0 of the written value, the second is bit 1 and so on.
+ * The write is grouped by the bank the pins live on, so on the character device or
+ * mmap backends each bank is set with one call and the pins switch together.
+ *
+ * <BR>Here is the example usage of the class:
+ * \code{.cpp}
+ * 
+ * int main() {
+ *   PinGroup bus({2, 3, 4, 5, 6, 7, 8, 9}); //8 bit bus, pin 2 is bit 0
+ *   bus.setOut();
+ *   bus.write(0xA5);
+ *   return 0;
+ * }
+ * \endcode
+ * <BR>
+ * 
+ * @note On the sysfs backend the pins are still written one after the other
+ */
+class PinGroup {
+	public:
+		/**
+		 * @brief PinGroup constructor and initializer
+		 *
+		 * This initializes the gpio in the backend the same way the Gpio class does
+		 *
+		 * @param pins The gpio pins (0 to 47) in bit order, at most 64 pins
+		 * @param release When no more instances of the object are detected auto release (default: false)
+		 * @param throwing Wether to throw erros like PinError or just surpress them (false to surpress) (default: true)
+		 * 
+		 * @see neo_gpio_write_mask()
+		 */
+		PinGroup(std::initializer_list<int> pins, bool release = false, bool throwing = true) {
+			Gpio::init(); //Use static instance
+			_count = 0;
+			_mask = 0;
+			_throwing = throwing;
+
+			for(int pin : pins) {
+				if(_count >= 64) break;
+				if(pin < 0 || pin >= GPIOPORTSL) {
+					if(_throwing) throw error::PinError(pin, 0, GPIOPORTSL - 1);
+					continue;
+				}
+				_pins[_count++] = pin;
+				_mask |= (1ULL << pin);
+			}
+
+			PinGroup::_in_use += 1; //Update usage count
+			PinGroup::_release = release; //If any release are false all are
+		}
+
+		/**
+		 * @brief PinGroup object deconstructor and pin release
+		 * 
+		 * Same as the Gpio deconstructor, the pins are only released when asked to in the constructor
+		 */
+		~PinGroup() {
+			PinGroup::_in_use -= 1;
+
+			if(PinGroup::_in_use == 0 && PinGroup::_release) Gpio::free();
+		}
+
+		/**
+		 * @brief Static writing of many pins at once
+		 *
+		 * Sets every gpio pin in the mask to the matching bit of values (bit n is gpio pin n)
+		 *
+		 * @return A boolean if the operation succeded or not
+		 * @param mask The pins to write
+		 * @param values The values to write to those pins
+		 * @param throws Optional value to throw if there is an error (default: true)
+		 */
+		static bool writeMask(uint64_t mask, uint64_t values, bool throws = true) {
+			int ret = neo_gpio_write_mask(mask, values);
+			if(throws && ret != NEO_OK) {
+				neo::error::Handler(ret, -1, 0, GPIOPORTSL, 0, "PinGroup", "Failed to writing to Gpio Pins");
+			}
+			return ret == NEO_OK;
+		}
+
+		/**
+		 * @brief Writing a value to the group
+		 *
+		 * Bit 0 of the value goes to the first pin in the group, bit 1 to the second and so on
+		 *
+		 * @return A boolean if the operation succeded
+		 * @param value The value to put on the group
+		 */
+		bool write(uint64_t value) {
+			uint64_t values = 0;
+			for(int i = 0; i < _count; i++) {
+				if((value >> i) & 1ULL) values |= (1ULL << _pins[i]);
+			}
+			return PinGroup::writeMask(_mask, values, _throwing);
+		}
+
+		/**
+		 * @brief Static snapshot of every gpio pin
+		 *
+		 * Reads all the pins at once into a bitmap (bit n is gpio pin n)
+		 *
+		 * @return The bitmap of the pins (0 when it failed and throws is false)
+		 * @param throws Optional value to throw if there is an error (default: true)
+		 */
+		static uint64_t readAll(bool throws = true) {
+			uint64_t bits = 0;
+			int ret = neo_gpio_read_all(&bits);
+			if(throws && ret != NEO_OK) {
+				neo::error::Handler(ret, -1, 0, GPIOPORTSL, 0, "PinGroup", "Failed to reading from Gpio Pins");
+			}
+			return bits;
+		}
+
+		/**
+		 * @brief Reading the value of the group
+		 *
+		 * The first pin of the group ends up in bit 0, the second in bit 1 and so on.
+		 * All the pins are taken from the same snapshot @see neo_gpio_read_all()
+		 *
+		 * @return The value of the group
+		 */
+		uint64_t read() {
+			uint64_t bits = PinGroup::readAll(_throwing), value = 0;
+			for(int i = 0; i < _count; i++) {
+				if((bits >> _pins[i]) & 1ULL) value |= (1ULL << i);
+			}
+			return value;
+		}
+
+		/**
+		 * @brief Setting the direction of every pin in the group
+		 *
+		 * @return A boolean if the operation succeded 
+		 * @param dir the value to set the direction either OUTPUT (1) or INPUT (0)
+		 *
+		 * @warning Do not set the same pin on the m4 to OUTPUT!
+		 */
+		bool setDir(int dir) {
+			bool passed = true;
+			for(int i = 0; i < _count; i++) {
+				passed = Gpio::pinMode(_pins[i], dir, _throwing) && passed;
+			}
+			return passed;
+		}
+
+		/**
+		 * @brief Setting all the pins to OUTPUT
+		 *
+		 * @return A boolean if the operation succeded
+		 *
+		 * @warning Do not set the same pin on the m4 to OUTPUT!
+		 */
+		bool setOut() {
+			return this->setDir(OUTPUT);
+		}
+
+		/**
+		 * @brief Setting all the pins to INPUT
+		 *
+		 * @return A boolean if the operation succeded
+		 */
+		bool setIn() {
+			return this->setDir(INPUT);
+		}
+
+		/**
+		 * @brief The gpio mask of the pins in the group (bit n is gpio pin n)
+		 *
+		 * @return The mask of the pins
+		 */
+		uint64_t mask() {
+			return _mask;
+		}
+
+	private:
+		int _pins[64]; //The pins in bit order
+		int _count; //Amount of pins in the group
+		uint64_t _mask; //The gpio mask of the group
+		bool _throwing;
+		static short _in_use; //Global object usage count
+		static bool _release; //Global to release on no object count
+};
+
+short PinGroup::_in_use = 0; //Set no object counts
+bool PinGroup::_release = false; //Set to automatically release
+
+/** @class Encoder neo.h
+ * @brief The quadrature encoder class that decodes an A/B encoder on two gpio pins
+ *
+ * This class attaches both pins to the interrupt engine and reads the position and
+ * velocity the dispatcher keeps, reading them never makes a syscall
+ *
+ * Example usage:
+ * \code{.cpp}
+ * neo::Encoder motor(4, 5); //A on pin 4, B on pin 5 counting every edge
+ * printf("At %lld going %f steps/s\n", (long long) motor.position(), motor.velocity());
+ * \endcode
+ */
+class Encoder {
+	public:
+		/**
+		 * @brief Encoder constructor and initializer
+		 *
+		 * This initializes the gpio in the backend the same way the Gpio class does and starts decoding
+		 *
+		 * @param pinA The gpio pin (0 to 47) of the A channel
+		 * @param pinB The gpio pin (0 to 47) of the B channel
+		 * @param mode NEO_ENCODER_X1, NEO_ENCODER_X2 or NEO_ENCODER_X4 (default: NEO_ENCODER_X4)
+		 * @param throwing Wether to throw erros like PinError or just surpress them (false to surpress) (default: true)
+		 *
+		 * @see neo_encoder_init()
+		 */
+		Encoder(int pinA, int pinB, int mode = NEO_ENCODER_X4, bool throwing = true) {
+			Gpio::init(); //Use static instance
+			_id = neo_encoder_init(pinA, pinB, mode);
+			if(throwing && _id < 0) {
+				neo::error::Handler(_id, pinA, 0, GPIOPORTSL, 0, "Encoder", "Failed to attach Encoder");
+			}
+		}
+
+		/**
+		 * @brief Encoder deconstructor, stops decoding and detaches both pins
+		 */
+		~Encoder() {
+			if(_id >= 0) neo_encoder_free(_id);
+		}
+
+		/**
+		 * @brief Getting the position
+		 *
+		 * @return The counted steps since the start or the last reset()
+		 */
+		int64_t position() {
+			return neo_encoder_position(_id);
+		}
+
+		/**
+		 * @brief Getting the velocity
+		 *
+		 * @return The velocity in steps per second @see neo_encoder_velocity()
+		 */
+		double velocity() {
+			return neo_encoder_velocity(_id);
+		}
+
+		/**
+		 * @brief Setting the current position as 0
+		 *
+		 * @return A boolean if the operation succeded
+		 */
+		bool reset() {
+			return neo_encoder_reset(_id) == NEO_OK;
+		}
+
+	private:
+		int _id; //The id of the encoder in the backend
+		Encoder(const Encoder&); //Only one object owns an encoder
+		Encoder& operator=(const Encoder&);
+};
+
 /** @class PWM neo.h
  * @brief The PWM class that handles all PWM controls
  * 
@@ -1149,7 +1943,7 @@ class PWM {
 		 *
 		 * @return A boolean if the operation succeded or not
 		 * @param port The port to statically write to
-		 * @param period The period of the pin between 1 and 100000000 (in nano seconds)
+		 * @param period The period of the pin between 1 and 1000000000 (in nano seconds)
 		 * @param throws Optional value to throw if there is an error (default: true)
 		 */
 		static bool setPeriod(int port, int period, bool throws = true) {
@@ -1167,7 +1961,7 @@ class PWM {
 		 * is essentially just a for loop, but to make it easier for the lazy people.
 		 *
 		 * @return A boolean if the operation succeded or not
-		 * @param period The period of the pin between 1 and 100000000 (in nano seconds)
+		 * @param period The period of the pin between 1 and 1000000000 (in nano seconds)
 		 * @param throws Optional value to throw if there is an error (default: true)
 		 */
 		static bool setAllPeriods(int period, bool throws = true) {
@@ -1184,13 +1978,82 @@ class PWM {
 		 * This will attempt to update the PWM period on the currently selected pin
 		 *
 		 * @return A boolean if the operation succeded or not
-		 * @param period The period of the pin between 1 and 100000000 (in nano seconds)
+		 * @param period The period of the pin between 1 and 1000000000 (in nano seconds)
 		 * @param throws Optional value to throw if there is an error (default: true)
 		 */
 		bool setPeriod(int period) {
 			return PWM::setPeriod(_held, period, _throwing);
 		}
 
+		/**
+		 * @brief Static setting PWM polarity
+		 *
+		 * This will attempt to update the PWM polarity on a SINGLE PIN @see neo_pwm_set_polarity()
+		 *
+		 * @return A boolean if the operation succeded or not
+		 * @param port The port to statically write to
+		 * @param inverted True for an active low pin
+		 * @param throws Optional value to throw if there is an error (default: true)
+		 */
+		static bool setPolarity(int port, bool inverted, bool throws = true) {
+			int ret = neo_pwm_set_polarity(port, (inverted) ? 1 : 0);
+			if(throws && ret != NEO_OK) {
+				neo::error::Handler(ret, port, 0, 1, (inverted) ? 1 : 0, "PWM", "Failed to setting polarity on PWM Pin");
+			}
+			return ret == NEO_OK;
+		}
+
+		/**
+		 * @brief Setting PWM polarity on selected object pin
+		 *
+		 * @return A boolean if the operation succeded or not
+		 * @param inverted True for an active low pin
+		 */
+		bool setPolarity(bool inverted) {
+			return PWM::setPolarity(_held, inverted, _throwing);
+		}
+
+		/**
+		 * @brief Static fading of a pin in the background
+		 *
+		 * The pin goes from it's duty cycle to the new one over the duration, this returns right away @see neo_pwm_ramp()
+		 *
+		 * @return A boolean if the operation succeded or not
+		 * @param port The port to statically fade
+		 * @param duty The duty cycle to end on between 0 (off) and 255 (full)
+		 * @param duration_ns How long the fade takes in nano seconds
+		 * @param curve NEO_RAMP_LINEAR, NEO_RAMP_GAMMA, NEO_RAMP_EASE_IN, NEO_RAMP_EASE_OUT or NEO_RAMP_EASE_IN_OUT (default: NEO_RAMP_LINEAR)
+		 * @param throws Optional value to throw if there is an error (default: true)
+		 */
+		static bool ramp(int port, int duty, uint64_t duration_ns, int curve = NEO_RAMP_LINEAR, bool throws = true) {
+			int ret = neo_pwm_ramp(NEO_RAMP_PWM, port, duty, duration_ns, curve);
+			if(throws && ret != NEO_OK) {
+				neo::error::Handler(ret, port, 0, 255, duty, "PWM", "Failed to ramp PWM Pin");
+			}
+			return ret == NEO_OK;
+		}
+
+		/**
+		 * @brief Fading the selected object pin in the background
+		 *
+		 * @return A boolean if the operation succeded or not
+		 * @param duty The duty cycle to end on between 0 (off) and 255 (full)
+		 * @param duration_ns How long the fade takes in nano seconds
+		 * @param curve The curve of the fade (default: NEO_RAMP_LINEAR) @see neo_pwm_ramp()
+		 */
+		bool ramp(int duty, uint64_t duration_ns, int curve = NEO_RAMP_LINEAR) {
+			return PWM::ramp(_held, duty, duration_ns, curve, _throwing);
+		}
+
+		/**
+		 * @brief Checking if the selected object pin is still fading
+		 *
+		 * @return True while the fade is running
+		 */
+		bool ramping() {
+			return neo_pwm_ramp_busy(NEO_RAMP_PWM, _held) == 1;
+		}
+
 	private:
 		int _held; //Current pin to use
 		bool _throwing;
@@ -1245,7 +2108,7 @@ class FakePWM {
 			FakePWM::init(); //Use static instance
 			_held = port;
 			_throwing = throwing;
-			_period = 20408; //~49KHz
+			_period = FAKEPWMPERIOD; //~490Hz (micro seconds)
 			
 			FakePWM::_in_use += 1; //Update usage count
 			FakePWM::_release = release; //If any release are false all are
@@ -1328,7 +2191,7 @@ class FakePWM {
 		 * @return A boolean if the operation succeded or not
 		 * @param port The port to statically write to
 		 * @param duty The duty cycle to write between 0 (off) and 255 (full) (An error will be thrown otherwise)
-		 * @param period The period of the pin between 1 and 100000000 (in nano seconds)
+		 * @param period The period of the pin between 1 and 1000000000 (in micro seconds)
 		 * @param throws Optional value to throw if there is an error (default: true)
 		 */
 		static bool writePeriod(int port, int duty, int period, bool throws = true) {
@@ -1345,7 +2208,7 @@ class FakePWM {
 		 * This will write a duty cycle to the gpio fake pwm pin and throw an exception if it failed to write.
 		 *
 		 * @return A boolean if the operation succeded 
-		 * @param period The period of the pin between 1 and 100000000 (in nano seconds)
+		 * @param period The period of the pin between 1 and 1000000000 (in micro seconds)
 		 * @param duty The value to write between 0 (off) and 255 (full) (An error will be thrown otherwise)
 		 * @param setDefault a boolean to overwrite the current default period(Just for this pin) (default: false)
 		 */
@@ -1368,16 +2231,130 @@ class FakePWM {
 			return FakePWM::writePeriod(_held, duty, _period, _throwing);
 		}
 		
+		/**
+		 * @brief Getting how well the selected object pin keeps it's timing
+		 *
+		 * @return True if a full period was measured @see neo_fake_pwm_stats()
+		 * @param stats Where to store the measurements
+		 * @param reset Start the measurements over after reading them (default: false)
+		 */
+		bool stats(neo_pwm_stats_t *stats, bool reset = false) {
+			return neo_fake_pwm_stats(_held, stats, (reset) ? 1 : 0) == NEO_OK;
+		}
+		
+		/**
+		 * @brief Static locking of fake pwm pins together on one period
+		 *
+		 * @return A boolean if the operation succeded or not
+		 * @param pins The gpio pins of the group
+		 * @param n The amount of pins (2 for NEO_PWM_COMPLEMENTARY)
+		 * @param period The period of the group in micro seconds
+		 * @param mode NEO_PWM_ALIGNED, NEO_PWM_STAGGERED or NEO_PWM_COMPLEMENTARY @see neo_fake_pwm_group()
+		 * @param dead The dead time of NEO_PWM_COMPLEMENTARY in micro seconds (default: 0)
+		 * @param throws Optional value to throw if there is an error (default: true)
+		 */
+		static bool group(const int *pins, int n, int period, int mode, int dead = 0, bool throws = true) {
+			int ret = neo_fake_pwm_group(pins, n, period, mode, dead);
+			if(throws && ret != NEO_OK) {
+				neo::error::Handler(ret, (pins != NULL && n > 0) ? pins[0] : -1, 0, GPIOPORTSL, 0, "FakePWM", "Failed to group FakePWM Pins");
+			}
+			return ret == NEO_OK;
+		}
+		
 		/**
 		 * @brief Setting PWM period on selected object pin
 		 *
 		 * This will attempt to update the PWM period on the currently selected pin
 		 *
 		 * @return A boolean if the operation succeded or not
-		 * @param the period of the pin between 1 and 100000000 (in nano seconds)
+		 * @param the period of the pin between 1 and 1000000000 (in micro seconds)
 		 */
-		void setPeriod(int period) {
+		bool setPeriod(int period) {
 			this->_period = period;
+			return FakePWM::setPeriod(_held, period, _throwing);
+		}
+
+		/**
+		 * @brief Static setting of the period of a single fake pwm pin
+		 *
+		 * @return A boolean if the operation succeded or not @see neo_fake_pwm_set_period()
+		 * @param port The port to statically write to
+		 * @param period The period of the pin between 1 and 1000000000 (in micro seconds)
+		 * @param throws Optional value to throw if there is an error (default: true)
+		 */
+		static bool setPeriod(int port, int period, bool throws = true) {
+			int ret = neo_fake_pwm_set_period(port, period);
+			if(throws && ret != NEO_OK) {
+				neo::error::Handler(ret, port, 0, 1000000000, period, "FakePWM", "Failed to setting period on FakePWM Pin");
+			}
+			return ret == NEO_OK;
+		}
+
+		/**
+		 * @brief Static setting of the polarity of a single fake pwm pin
+		 *
+		 * @return A boolean if the operation succeded or not @see neo_fake_pwm_set_polarity()
+		 * @param port The port to statically write to
+		 * @param inverted True for an active low pin
+		 * @param throws Optional value to throw if there is an error (default: true)
+		 */
+		static bool setPolarity(int port, bool inverted, bool throws = true) {
+			int ret = neo_fake_pwm_set_polarity(port, (inverted) ? 1 : 0);
+			if(throws && ret != NEO_OK) {
+				neo::error::Handler(ret, port, 0, 1, (inverted) ? 1 : 0, "FakePWM", "Failed to setting polarity on FakePWM Pin");
+			}
+			return ret == NEO_OK;
+		}
+
+		/**
+		 * @brief Setting the polarity of the selected object pin
+		 *
+		 * @return A boolean if the operation succeded or not
+		 * @param inverted True for an active low pin
+		 */
+		bool setPolarity(bool inverted) {
+			return FakePWM::setPolarity(_held, inverted, _throwing);
+		}
+
+		/**
+		 * @brief Static fading of a pin in the background
+		 *
+		 * The pin goes from it's duty cycle to the new one over the duration, this returns right away @see neo_pwm_ramp()
+		 *
+		 * @return A boolean if the operation succeded or not
+		 * @param port The port to statically fade
+		 * @param duty The duty cycle to end on between 0 (off) and 255 (full)
+		 * @param duration_ns How long the fade takes in nano seconds
+		 * @param curve NEO_RAMP_LINEAR, NEO_RAMP_GAMMA, NEO_RAMP_EASE_IN, NEO_RAMP_EASE_OUT or NEO_RAMP_EASE_IN_OUT (default: NEO_RAMP_LINEAR)
+		 * @param throws Optional value to throw if there is an error (default: true)
+		 */
+		static bool ramp(int port, int duty, uint64_t duration_ns, int curve = NEO_RAMP_LINEAR, bool throws = true) {
+			int ret = neo_pwm_ramp(NEO_RAMP_FAKE_PWM, port, duty, duration_ns, curve);
+			if(throws && ret != NEO_OK) {
+				neo::error::Handler(ret, port, 0, 255, duty, "FakePWM", "Failed to ramp FakePWM Pin");
+			}
+			return ret == NEO_OK;
+		}
+
+		/**
+		 * @brief Fading the selected object pin in the background
+		 *
+		 * @return A boolean if the operation succeded or not
+		 * @param duty The duty cycle to end on between 0 (off) and 255 (full)
+		 * @param duration_ns How long the fade takes in nano seconds
+		 * @param curve The curve of the fade (default: NEO_RAMP_LINEAR) @see neo_pwm_ramp()
+		 */
+		bool ramp(int duty, uint64_t duration_ns, int curve = NEO_RAMP_LINEAR) {
+			return FakePWM::ramp(_held, duty, duration_ns, curve, _throwing);
+		}
+
+		/**
+		 * @brief Checking if the selected object pin is still fading
+		 *
+		 * @return True while the fade is running
+		 */
+		bool ramping() {
+			return neo_pwm_ramp_busy(NEO_RAMP_FAKE_PWM, _held) == 1;
 		}
 
 	private:
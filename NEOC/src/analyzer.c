@@ -0,0 +1,240 @@
+/*----------------------------------------------------------------------||
+|                                                                        |
+| Copyright (C) 2016 by David Smerkous                                   |
+| License Date: 11/27/2016                                               |
+| Modifiers: none                                                        |
+|                                                                        |
+| NEOC (libneo) is free software: you can redistribute it and/or modify  |
+|   it under the terms of the GNU General Public License as published by |
+|   the Free Software Foundation, either version 3 of the License, or    |
+|   (at your option) any later version.                                  |
+|                                                                        |
+| NEOC (libneo) is distributed in the hope that it will be useful,       |
+|   but WITHOUT ANY WARRANTY; without even the implied warranty of       |
+|   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        |
+|   GNU General Public License for more details.                         |
+|                                                                        |
+| You should have received a copy of the GNU General Public License      |
+|   along with this program.  If not, see http://www.gnu.org/licenses/   |
+|                                                                        |
+||----------------------------------------------------------------------*/
+
+/**
+ * 
+ * @file analyzer.c
+ * @author David Smerkous
+ * @date 11/28/2016
+ * @brief Logic analyzer, samples a set of gpio pins at a fixed rate into a ring of bitmaps
+ *
+ * @details A sampling thread (pinned to a cpu if asked) reads the pins at every tick of the
+ * rate into a buffer given by the user, with one read per bank like neo_gpio_read_all().
+ * The buffer is a ring until the trigger (a pattern or an edge) is seen, then it's filled with
+ * the samples after the trigger and the thread stops. Nothing is allocated while sampling
+ * 
+ * @note Use the NEO_GPIO_MMAP backend for 100kHz, a sample is then just a few register reads
+ */
+
+#define _GNU_SOURCE //For pthread_attr_setaffinity_np
+
+#include <neo.h>
+
+#ifndef DOXYGEN_SKIP
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+
+neo_analyzer_config_t neo_la_conf; //The settings of the current capture
+uint64_t *neo_la_buf = NULL; //The ring of samples, belongs to the user
+uint64_t neo_la_depth = 0;
+
+pthread_t neo_la_thread;
+int neo_la_active = 0; //If the thread was started and not joined yet
+int neo_la_abort = 0; //Set by neo_analyzer_stop
+neo_analyzer_result_t neo_la_result;
+
+//Current CLOCK_MONOTONIC time in nanoseconds
+uint64_t __neo_la_now() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+//Checks a sample against the trigger
+int __neo_la_triggered(uint64_t prev, uint64_t cur) {
+	uint64_t mask = neo_la_conf.trigger_mask;
+
+	switch(neo_la_conf.trigger) {
+		case NEO_TRIGGER_PATTERN: return (cur & mask) == (neo_la_conf.trigger_value & mask);
+		case NEO_TRIGGER_RISING: return (~prev & cur & mask) != 0;
+		case NEO_TRIGGER_FALLING: return (prev & ~cur & mask) != 0;
+		case NEO_TRIGGER_EDGE: return ((prev ^ cur) & mask) != 0;
+		default: return 1; //No trigger starts right away
+	}
+}
+
+//The sampling thread, one sample per tick of the rate
+void *__neo_la_loop(void *arg) {
+	neo_analyzer_result_t *res = &neo_la_result;
+	uint64_t period = 1000000000ULL / neo_la_conf.rate_hz;
+	uint64_t post = neo_la_depth - (uint64_t) neo_la_conf.pre;
+	uint64_t n = 0, trig = 0, start, next, now, wake, rested, sample = 0, prev = 0;
+	int triggered = 0;
+	struct timespec ts;
+	(void) arg;
+
+	start = next = rested = __neo_la_now() + period;
+
+	while(!__atomic_load_n(&neo_la_abort, __ATOMIC_RELAXED)) {
+		//Short periods are spun (the sleep wouldn't wake up in time) but still give the cpu up every LABUSYNS
+		now = __neo_la_now();
+		if(period > LASPINNS || now >= rested + LABUSYNS) {
+			wake = (period > LASPINNS) ? next : now + LARESTNS;
+			ts.tv_sec = wake / 1000000000ULL;
+			ts.tv_nsec = wake % 1000000000ULL;
+			if(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) continue;
+			rested = __neo_la_now();
+		}
+		while((now = __neo_la_now()) < next);
+
+		//Ticks we were too late for repeat the last sample, so sample n is always at start + n * period
+		while(now >= next + period && n > 0) {
+			neo_la_buf[n % neo_la_depth] = sample | NEO_LA_REPEATED;
+			res->missed++;
+			n++;
+			next += period;
+			if(triggered && n - trig >= post) break;
+		}
+		if(triggered && n - trig >= post) break;
+
+		if(__neo_gpio_sample(neo_la_conf.pins, &sample) != NEO_OK) sample = prev;
+		neo_la_buf[n % neo_la_depth] = sample;
+
+		if(!triggered && (n > 0 || neo_la_conf.trigger == NEO_TRIGGER_NONE || neo_la_conf.trigger == NEO_TRIGGER_PATTERN)
+					&& __neo_la_triggered(prev, sample)) {
+			triggered = 1;
+			trig = n;
+		}
+
+		prev = sample;
+		n++;
+		next += period;
+		if(triggered && n - trig >= post) break; //Got everything after the trigger
+	}
+
+	//Describe the ring in the order the samples were taken
+	res->count = (int) ((n < neo_la_depth) ? n : neo_la_depth);
+	res->first = (int) ((n - res->count) % neo_la_depth);
+	res->trigger = (triggered) ? (int) (trig - (n - res->count)) : -1;
+	res->start_ns = start + (n - res->count) * period;
+	res->period_ns = period;
+	res->samples = n;
+	return NULL;
+}
+
+#endif
+
+/**
+ * @brief Starts sampling gpio pins like a logic analyzer
+ * 
+ * The pins of config.pins are sampled config.rate_hz times a second into buf (bit n is gpio pin n).
+ * Until the trigger is seen buf is a ring keeping the newest samples, after it the capture goes on
+ * for depth - config.pre more samples and stops, so the trigger has up to config.pre samples before it.
+ * The triggers are NEO_TRIGGER_NONE (starts right away), NEO_TRIGGER_PATTERN (the pins of trigger_mask
+ * equal trigger_value) and NEO_TRIGGER_RISING/NEO_TRIGGER_FALLING/NEO_TRIGGER_EDGE (any pin of
+ * trigger_mask changes that way). This returns right away @see neo_analyzer_wait()
+ * 
+ * @return NEO_OK, NEO_FAIL if a capture is running or the config is wrong, NEO_PERIOD_ERROR if the rate
+ * is out of range or NEO_UNUSABLE_ERROR/NEO_PIN_ERROR if a pin can't be read
+ * @param config The pins, rate, trigger, pre trigger depth and cpu to pin the thread to (-1 for any)
+ * @param buf The ring to store the samples in, must stay valid until the capture is done
+ * @param depth The amount of samples buf holds
+ *
+ * @note The thread asks for SCHED_FIFO and falls back to a normal thread when it's not allowed
+ * @note Ticks the thread was too late for repeat the sample before with NEO_LA_REPEATED set, mask it off to get the pins
+ * @warning Rates above 20kHz (periods under LASPINNS) are busy waited, the thread only sleeps LARESTNS every LABUSYNS
+ * so the rest of a single core system keeps running. Those sleeps show up as NEO_LA_REPEATED samples
+ */
+int neo_analyzer_start(const neo_analyzer_config_t *config, uint64_t *buf, int depth) {
+	struct sched_param param;
+	pthread_attr_t attr;
+	cpu_set_t cpus;
+	int pin, ret;
+
+	if(neo_la_active) return NEO_FAIL;
+	if(config == NULL || buf == NULL || depth < 1) return NEO_FAIL;
+	if(config->pre < 0 || config->pre >= depth) return NEO_FAIL;
+	if(config->rate_hz < 1 || config->rate_hz > LAMAXHZ) return NEO_PERIOD_ERROR;
+	if(config->pins == 0 || (config->pins >> GPIOPORTSL)) return NEO_PIN_ERROR;
+
+	//Open every pin now, nothing gets opened while sampling
+	for(pin = 0; pin < GPIOPORTSL; pin++) {
+		if(((config->pins >> pin) & 1ULL) && __neo_gpio_ready(pin) != NEO_OK) return NEO_UNUSABLE_ERROR;
+	}
+
+	neo_la_conf = *config;
+	neo_la_buf = buf;
+	neo_la_depth = (uint64_t) depth;
+	neo_la_abort = 0;
+	memset(&neo_la_result, 0, sizeof(neo_la_result));
+
+	pthread_attr_init(&attr);
+	pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+	pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+	param.sched_priority = LAPRIORITY;
+	pthread_attr_setschedparam(&attr, &param);
+	if(config->cpu >= 0) {
+		CPU_ZERO(&cpus);
+		CPU_SET(config->cpu, &cpus);
+		pthread_attr_setaffinity_np(&attr, sizeof(cpus), &cpus);
+	}
+
+	ret = pthread_create(&neo_la_thread, &attr, __neo_la_loop, NULL);
+	if(ret == EPERM) { //Not allowed real time, keep the cpu
+		pthread_attr_setinheritsched(&attr, PTHREAD_INHERIT_SCHED);
+		ret = pthread_create(&neo_la_thread, &attr, __neo_la_loop, NULL);
+	}
+	pthread_attr_destroy(&attr);
+	if(ret != 0) return NEO_FAIL;
+
+	neo_la_active = 1;
+	return NEO_OK;
+}
+
+/**
+ * @brief Waits for the capture to be done and gets where the samples are
+ * 
+ * Sample i in the order they were taken is buf[(result.first + i) % depth] at
+ * result.start_ns + i * result.period_ns
+ * 
+ * @return NEO_OK or NEO_FAIL if no capture was started
+ * @param result Where to store the layout of the samples (can be NULL)
+ *
+ * @warning This only comes back after the trigger was seen, @see neo_analyzer_stop() to give up on it
+ */
+int neo_analyzer_wait(neo_analyzer_result_t *result) {
+	if(!neo_la_active) return NEO_FAIL;
+
+	pthread_join(neo_la_thread, NULL);
+	neo_la_active = 0;
+
+	if(result != NULL) *result = neo_la_result;
+	return NEO_OK;
+}
+
+/**
+ * @brief Stops the capture right away and gets where the samples are
+ * 
+ * @return NEO_OK or NEO_FAIL if no capture was started
+ * @param result Where to store the layout of the samples taken so far, trigger is -1 if it wasn't seen (can be NULL)
+ */
+int neo_analyzer_stop(neo_analyzer_result_t *result) {
+	if(!neo_la_active) return NEO_FAIL;
+
+	__atomic_store_n(&neo_la_abort, 1, __ATOMIC_RELAXED);
+	return neo_analyzer_wait(result);
+}
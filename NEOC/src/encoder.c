@@ -0,0 +1,303 @@
+/*----------------------------------------------------------------------||
+|                                                                        |
+| Copyright (C) 2016 by David Smerkous                                   |
+| License Date: 11/27/2016                                               |
+| Modifiers: none                                                        |
+|                                                                        |
+| NEOC (libneo) is free software: you can redistribute it and/or modify  |
+|   it under the terms of the GNU General Public License as published by |
+|   the Free Software Foundation, either version 3 of the License, or    |
+|   (at your option) any later version.                                  |
+|                                                                        |
+| NEOC (libneo) is distributed in the hope that it will be useful,       |
+|   but WITHOUT ANY WARRANTY; without even the implied warranty of       |
+|   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        |
+|   GNU General Public License for more details.                         |
+|                                                                        |
+| You should have received a copy of the GNU General Public License      |
+|   along with this program.  If not, see http://www.gnu.org/licenses/   |
+|                                                                        |
+||----------------------------------------------------------------------*/
+
+/**
+ * 
+ * @file encoder.c
+ * @author David Smerkous
+ * @date 11/28/2016
+ * @brief Quadrature encoder decoding on pairs of gpio pins
+ *
+ * @details The A and B pins of an encoder are attached to the interrupt engine and every raw
+ * edge is decoded in the dispatcher thread, before the callbacks and the debounce. The position
+ * and velocity are kept in atomics so reading them never costs a syscall or a lock
+ * 
+ * @note Don't debounce the encoder pins, the decoder already ignores the steps that go back and forth
+ */
+
+#include <neo.h>
+
+#ifndef DOXYGEN_SKIP
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+
+struct encoder_h {
+	int used; //If the slot is taken, from the claim in neo_encoder_init to the end of neo_encoder_free
+	int ready; //If both pins are attached and the id works
+	int id; //The id handed out for it, the slot plus a multiple of ENCODERSL so a stale id never matches a new encoder
+	int pinA, pinB; //The gpio pins of the A and B channels
+	int mode; //NEO_ENCODER_X1, NEO_ENCODER_X2 or NEO_ENCODER_X4
+	int state; //Last known (A << 1) | B, only touched by the dispatcher
+
+	int64_t count; //Counted steps since the attach
+	int64_t zero; //The count position 0 was set at
+	uint64_t last; //Time of the last step
+
+	//The velocity is measured over windows of at least ENCODERVELNS
+	uint64_t win_ts;
+	int64_t win_count;
+	double velocity; //Steps per second
+};
+
+//Declare alias for struct
+typedef struct encoder_h encoder_t;
+
+encoder_t neo_encoders[ENCODERSL];
+int neo_encoder_ids = 0; //Ids handed out so far
+
+//Claiming and releasing the slots, never held over an attach or a detach (those can end up in __neo_encoder_free_all)
+pthread_mutex_t neo_encoder_lock = PTHREAD_MUTEX_INITIALIZER;
+
+//The encoder of every gpio pin plus one (0 is none)
+int neo_encoder_of[GPIOPORTSL];
+
+//Steps for every (old state << 2) | new state, A leading B counts up
+const signed char neo_encoder_steps[16] = {
+	 0, -1, +1,  0,
+	+1,  0,  0, -1,
+	-1,  0,  0, +1,
+	 0, +1, -1,  0
+};
+
+//Decodes a raw edge of a pin that belongs to an encoder (called by the dispatcher)
+void __neo_encoder_edge(int pin, int value, uint64_t ts) {
+	int ind = __atomic_load_n(&neo_encoder_of[pin], __ATOMIC_ACQUIRE) - 1;
+	encoder_t *e;
+	int state, step;
+
+	if(ind < 0 || value == NEO_FAIL) return;
+	e = &neo_encoders[ind];
+
+	if(pin == e->pinA) state = (value << 1) | (e->state & 1);
+	else state = (e->state & 2) | value;
+
+	step = neo_encoder_steps[(e->state << 2) | state];
+	if(e->mode == NEO_ENCODER_X2 && (e->state ^ state) != 2) step = 0; //Only A edges
+	if(e->mode == NEO_ENCODER_X1 && !((e->state ^ state) == 2 && (state & 2))) step = 0; //Only A rising
+	e->state = state;
+	if(step == 0) return;
+
+	int64_t count = __atomic_add_fetch(&e->count, step, __ATOMIC_RELAXED);
+	__atomic_store_n(&e->last, ts, __ATOMIC_RELAXED);
+
+	if(ts < e->win_ts || ts - e->win_ts > ENCODERIDLENS) { //Was standing still, start a fresh window
+		e->win_ts = ts;
+		e->win_count = count;
+	} else if(ts - e->win_ts >= ENCODERVELNS) {
+		double velocity = (double) (count - e->win_count) * 1000000000.0 / (double) (ts - e->win_ts);
+		__atomic_store(&e->velocity, &velocity, __ATOMIC_RELAXED);
+		e->win_ts = ts;
+		e->win_count = count;
+	}
+}
+
+//The encoder of an id, NULL if it isn't one (anymore)
+encoder_t *__neo_encoder_get(int id) {
+	encoder_t *e;
+
+	if(id < 0) return NULL;
+	e = &neo_encoders[id % ENCODERSL];
+	return (__atomic_load_n(&e->ready, __ATOMIC_ACQUIRE) && e->id == id) ? e : NULL;
+}
+
+//Forgets every encoder, their pins are detached by the caller (called by __neo_interrupt_free)
+void __neo_encoder_free_all() {
+	int ind;
+
+	pthread_mutex_lock(&neo_encoder_lock);
+	for(ind = 0; ind < GPIOPORTSL; ind++) __atomic_store_n(&neo_encoder_of[ind], 0, __ATOMIC_RELEASE);
+	for(ind = 0; ind < ENCODERSL; ind++) {
+		__atomic_store_n(&neo_encoders[ind].ready, 0, __ATOMIC_RELEASE);
+		__atomic_store_n(&neo_encoders[ind].used, 0, __ATOMIC_RELEASE);
+	}
+	pthread_mutex_unlock(&neo_encoder_lock);
+}
+
+//Attaches both edges of an encoder pin, keeping any callback the user put on it
+int __neo_encoder_attach(int pin) {
+	if(neo_gpio_digital_read(pin) < 0) return NEO_UNUSABLE_ERROR;
+	if(neo_gpio_set_interrupt_mode(pin, BOTHEDGE) == NEO_OK) return NEO_OK;
+	return neo_gpio_attach_interrupt(pin, BOTHEDGE, NULL);
+}
+
+#endif
+
+/**
+ * @brief Starts decoding a quadrature encoder on two gpio pins
+ * 
+ * Both pins are set to input and attached to the interrupt engine on both edges (without a callback
+ * if they had none). NEO_ENCODER_X4 counts every edge of A and B, NEO_ENCODER_X2 every edge of A and
+ * NEO_ENCODER_X1 the rising edges of A. The count goes up when A leads B
+ * 
+ * @return The id of the encoder (0 and up) or NEO_PIN_ERROR/NEO_UNUSABLE_ERROR/NEO_INTERRUPT_ERROR/NEO_FAIL if none are left
+ * @param pinA The gpio pin of the A channel
+ * @param pinB The gpio pin of the B channel
+ * @param mode NEO_ENCODER_X1, NEO_ENCODER_X2 or NEO_ENCODER_X4
+ *
+ * @note At most 8 encoders can be used at once, neo_gpio_free() stops all of them (their ids stop working)
+ */
+int neo_encoder_init(int pinA, int pinB, int mode) {
+	int ind, id, ret;
+	encoder_t *e;
+
+	if(pinA < 0 || pinA >= GPIOPORTSL || pinB < 0 || pinB >= GPIOPORTSL || pinA == pinB) return NEO_PIN_ERROR;
+	if(mode != NEO_ENCODER_X1 && mode != NEO_ENCODER_X2 && mode != NEO_ENCODER_X4) return NEO_FAIL;
+
+	//Claim a slot and the pins, the attach happens without the lock
+	pthread_mutex_lock(&neo_encoder_lock);
+	for(ind = 0; ind < ENCODERSL; ind++) {
+		e = &neo_encoders[ind];
+		if(e->used && (e->pinA == pinA || e->pinB == pinA || e->pinA == pinB || e->pinB == pinB)) { //Already decoding
+			pthread_mutex_unlock(&neo_encoder_lock);
+			return NEO_UNUSABLE_ERROR;
+		}
+	}
+
+	for(ind = 0; ind < ENCODERSL && neo_encoders[ind].used; ind++);
+	if(ind == ENCODERSL) {
+		pthread_mutex_unlock(&neo_encoder_lock);
+		return NEO_FAIL;
+	}
+
+	e = &neo_encoders[ind];
+	memset(e, 0, sizeof(*e));
+	neo_encoder_ids = (neo_encoder_ids + 1) % (0x7FFFFFFF / ENCODERSL);
+	id = e->id = neo_encoder_ids * ENCODERSL + ind;
+	e->used = 1;
+	e->pinA = pinA;
+	e->pinB = pinB;
+	e->mode = mode;
+	pthread_mutex_unlock(&neo_encoder_lock);
+
+	ret = __neo_encoder_attach(pinA);
+	if(ret == NEO_OK) ret = __neo_encoder_attach(pinB);
+
+	pthread_mutex_lock(&neo_encoder_lock);
+	if(ret == NEO_OK && !(e->used && e->id == id)) ret = NEO_INTERRUPT_ERROR; //Freed by neo_gpio_free() meanwhile
+	if(ret != NEO_OK) {
+		if(e->id == id) __atomic_store_n(&e->used, 0, __ATOMIC_RELEASE);
+		pthread_mutex_unlock(&neo_encoder_lock);
+		return ret;
+	}
+
+	e->state = (neo_gpio_digital_read(pinA) << 1) | neo_gpio_digital_read(pinB);
+
+	//Hand the encoder to the dispatcher last
+	__atomic_store_n(&neo_encoder_of[pinA], ind + 1, __ATOMIC_RELEASE);
+	__atomic_store_n(&neo_encoder_of[pinB], ind + 1, __ATOMIC_RELEASE);
+	__atomic_store_n(&e->ready, 1, __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&neo_encoder_lock);
+	return id;
+}
+
+/**
+ * @brief Stops decoding an encoder
+ * 
+ * @return NEO_OK or NEO_FAIL if the id isn't an encoder
+ * @param id The id returned by neo_encoder_init()
+ *
+ * @note Both pins are detached from the interrupt engine @see neo_gpio_detach_interrupt()
+ */
+int neo_encoder_free(int id) {
+	int pinA, pinB;
+	encoder_t *e;
+
+	pthread_mutex_lock(&neo_encoder_lock);
+	e = __neo_encoder_get(id);
+	if(e == NULL) { //Never was or already freed (neo_gpio_free frees them all)
+		pthread_mutex_unlock(&neo_encoder_lock);
+		return NEO_FAIL;
+	}
+
+	//The id stops working now, the slot and the pins stay claimed until they're detached
+	pinA = e->pinA;
+	pinB = e->pinB;
+	__atomic_store_n(&e->ready, 0, __ATOMIC_RELEASE);
+	__atomic_store_n(&neo_encoder_of[pinA], 0, __ATOMIC_RELEASE);
+	__atomic_store_n(&neo_encoder_of[pinB], 0, __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&neo_encoder_lock);
+
+	neo_gpio_detach_interrupt(pinA);
+	neo_gpio_detach_interrupt(pinB);
+
+	pthread_mutex_lock(&neo_encoder_lock);
+	if(e->id == id) __atomic_store_n(&e->used, 0, __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&neo_encoder_lock);
+	return NEO_OK;
+}
+
+/**
+ * @brief Gets the position of an encoder
+ * 
+ * @return The counted steps since the attach or the last neo_encoder_reset() (0 if the id isn't an encoder)
+ * @param id The id returned by neo_encoder_init()
+ */
+int64_t neo_encoder_position(int id) {
+	encoder_t *e = __neo_encoder_get(id);
+
+	if(e == NULL) return 0;
+
+	return __atomic_load_n(&e->count, __ATOMIC_RELAXED) - __atomic_load_n(&e->zero, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Gets the velocity of an encoder
+ * 
+ * The velocity is measured in the dispatcher over windows of at least 20ms of steps
+ * 
+ * @return The velocity in steps per second, 0 if it didn't step for 250ms or the id isn't an encoder
+ * @param id The id returned by neo_encoder_init()
+ */
+double neo_encoder_velocity(int id) {
+	struct timespec now;
+	uint64_t last, ns;
+	double velocity;
+	encoder_t *e = __neo_encoder_get(id);
+
+	if(e == NULL) return 0.0;
+
+	clock_gettime(CLOCK_MONOTONIC, &now); //The vdso clock, no syscall
+	ns = (uint64_t) now.tv_sec * 1000000000ULL + now.tv_nsec;
+	last = __atomic_load_n(&e->last, __ATOMIC_RELAXED);
+	if(ns > last && ns - last > ENCODERIDLENS) return 0.0; //Standing still
+
+	__atomic_load(&e->velocity, &velocity, __ATOMIC_RELAXED);
+	return velocity;
+}
+
+/**
+ * @brief Sets the current position of an encoder as 0
+ * 
+ * @return NEO_OK or NEO_FAIL if the id isn't an encoder
+ * @param id The id returned by neo_encoder_init()
+ */
+int neo_encoder_reset(int id) {
+	encoder_t *e = __neo_encoder_get(id);
+
+	if(e == NULL) return NEO_FAIL;
+
+	__atomic_store_n(&e->zero, __atomic_load_n(&e->count, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+	return NEO_OK;
+}
@@ -43,9 +43,12 @@
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
-#include <glib.h>
 #include <pthread.h>
 #include <fcntl.h>
+#include <stdint.h>
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+#include <sys/mman.h>
 
 //Array with all of the mapped ports to the correct bank numbers as indexes - 1
 const char * const GPIOPORTS[] = {"178", "179", "104", "143", "142", "141", "140", 
@@ -58,7 +61,7 @@ const char * const GPIOPORTS[] = {"178", "179", "104", "143", "142", "141", "140
 
 //When attempting to export test all ports as well as document the direction and setting
 unsigned char USABLEGPIO[GPIOPORTSL], DIRGPIO[GPIOPORTSL], VALGPIO[GPIOPORTSL],
-		USEDINT[GPIOPORTSL];
+		OPENGPIO[GPIOPORTSL];
 
 //P = port pin D = direction pin E = edge L = active low
 FILE* gpioP[GPIOPORTSL];
@@ -66,100 +69,422 @@ FILE* gpioD[GPIOPORTSL];
 FILE* gpioE[GPIOPORTSL];
 FILE* gpioA[GPIOPORTSL];
 
+//The selected backend for reads and writes (set by neo_gpio_init_backend)
+int neo_gpio_backend = NEO_GPIO_SYSFS;
+
+//The bank (gpiochip) and line offset of each port, B = bank L = line I = request index
+int GPIOBANK[GPIOPORTSL], GPIOLINE[GPIOPORTSL], GPIOINDEX[GPIOPORTSL];
+
+//Character device line request, one per bank holding all the usable lines of that bank
+struct gpio_chip_h {
+	int fd; //Line request file descriptor (-1 when the bank isn't requested)
+	int lines; //Amount of lines in the request
+	unsigned int offsets[GPIOBANKSIZE]; //The line offsets in request order
+	uint64_t flags[GPIOBANKSIZE]; //The current config flags of each requested line
+	uint64_t outputs; //Last written output values (bit per request index)
+};
+
+//Declare alias for struct
+typedef struct gpio_chip_h gpio_chip_t;
+
+gpio_chip_t neo_gpio_chips[GPIOBANKL];
+
+//Memory mapped bank registers and where they get mapped from (@see neo_gpio_set_mmap_source)
+volatile uint32_t *neo_gpio_regs = NULL;
+char neo_gpio_mmap_path[256] = GPIOMMAPPATH;
+unsigned long neo_gpio_mmap_base = GPIOMMAPBASE;
+
+//Gets the register of a bank (the register offsets are in bytes)
+#define GPIOREG(bank, reg) (neo_gpio_regs[((bank) * GPIOMMAPSTRIDE + (reg)) / 4])
+
+//Per pin lock for the sysfs direction, edge and active_low streams and the first open of the pin
+pthread_mutex_t neo_gpio_locks[GPIOPORTSL] = { [0 ... GPIOPORTSL - 1] = PTHREAD_MUTEX_INITIALIZER };
+
+//Per bank lock for the state the pins of a bank share (chardev request, mmap read-modify-writes)
+pthread_mutex_t neo_gpio_bank_locks[GPIOBANKL] = { [0 ... GPIOBANKL - 1] = PTHREAD_MUTEX_INITIALIZER };
+
 //Double free and initializing error fixed by global flag
 unsigned char neo_gpio_freed = 2;
 
 //Set the global exit function
 unsigned char neo_exit_set = 2;
 
-//Define the function pointer interrupt to attach to
-typedef void (*interruptfunc)(int, int);
+#ifdef GPIO_V2_GET_LINE_IOCTL
 
-struct interrupt_h {
-	int pinNum; //Currently handled pin number
-	int attached; //If pin is attached to interrupt
-	int fd; //File descriptor for watcher
-	
-	interruptfunc intfunc; //The callback function to handle attachment
-};
+//Pushes the tracked flags and output values of a bank to its line request
+int __neo_chip_apply(int bank) {
+	gpio_chip_t *chip = &neo_gpio_chips[bank];
+	struct gpio_v2_line_config conf;
+	uint64_t omask = 0;
+	unsigned int a;
+	int l;
 
-//Declare alias for struct
-typedef struct interrupt_h interrupt_t;
+	if(chip->fd < 0 || chip->lines < 1) return NEO_UNUSABLE_ERROR;
+
+	memset(&conf, 0, sizeof(conf));
+	conf.flags = chip->flags[0]; //The first line is the default of the request
+
+	for(l = 0; l < chip->lines; l++) {
+		if(chip->flags[l] & GPIO_V2_LINE_FLAG_OUTPUT) omask |= (1ULL << l);
+		if(chip->flags[l] == conf.flags) continue;
 
-//Thread managing for the gpio interrupts
-interrupt_t neo_gpio_interrupts[GPIOPORTSL + 2];
+		//Lines with the same flags share one attribute
+		for(a = 0; a < conf.num_attrs; a++) {
+			if(conf.attrs[a].attr.flags == chip->flags[l]) break;
+		}
+
+		if(a == conf.num_attrs) {
+			//Always keep the last attribute free for the output values
+			if(a >= GPIO_V2_LINE_NUM_ATTRS_MAX - 1) return NEO_UNUSABLE_ERROR;
+			conf.attrs[a].attr.id = GPIO_V2_LINE_ATTR_ID_FLAGS;
+			conf.attrs[a].attr.flags = chip->flags[l];
+			conf.num_attrs++;
+		}
+		conf.attrs[a].mask |= (1ULL << l);
+	}
+
+	//Outputs would drop to inactive on reconfigure, so keep the last written values
+	if(omask) {
+		a = conf.num_attrs++;
+		conf.attrs[a].attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+		conf.attrs[a].attr.values = chip->outputs;
+		conf.attrs[a].mask = omask;
+	}
+
+	if(ioctl(chip->fd, GPIO_V2_LINE_SET_CONFIG_IOCTL, &conf) < 0) return NEO_UNUSABLE_ERROR;
+	return NEO_OK;
+}
+
+//Requests all the mapped lines of a bank as inputs with one line request
+int __neo_chip_request(int bank) {
+	gpio_chip_t *chip = &neo_gpio_chips[bank];
+	struct gpio_v2_line_request req;
+	char path[strlen(GPIOCHIPPATH) + 4];
+	int cfd, i, l, fail;
+
+	fail = NEO_OK;
+	chip->fd = -1;
+	chip->lines = 0;
+	chip->outputs = 0;
+
+	sprintf(path, GPIOCHIPPATH, bank);
+	cfd = open(path, O_RDWR | O_CLOEXEC);
+
+	for(i = 0; i < GPIOPORTSL; i++) {
+		if(GPIOBANK[i] != bank) continue;
+		GPIOINDEX[i] = -1;
+		if(cfd < 0) continue;
+
+		//Some ports share the same line so look for it first
+		for(l = 0; l < chip->lines; l++) {
+			if(chip->offsets[l] == (unsigned int) GPIOLINE[i]) break;
+		}
 
-const int buf_r_size = 3; //3 char buffer max (to be generous to the reading)
+		if(l == chip->lines) {
+			//Probe the line alone, so one line in use doesn't fail the whole bank
+			memset(&req, 0, sizeof(req));
+			req.offsets[0] = GPIOLINE[i];
+			req.num_lines = 1;
+			req.config.flags = GPIO_V2_LINE_FLAG_INPUT;
+			strcpy(req.consumer, GPIOCONSUMER);
 
-static gboolean __neo_interrupt_event(GIOChannel *ch, GIOCondition cond, 
-				gpointer data) {
-	//First interrupt is always called, lets fix that per pin
-	interrupt_t t_inter = (*(interrupt_t *)(data));
-	gchar r_buff[buf_r_size]; //Store data buffer
-	gsize current_read = 0; //Current byte size read
-	GError *err = 0; //Error holder
+			if(ioctl(cfd, GPIO_V2_GET_LINE_IOCTL, &req) < 0) {
+				fail = NEO_UNUSABLE_ERROR;
+				continue;
+			}
+			close(req.fd);
+
+			chip->offsets[l] = GPIOLINE[i];
+			chip->flags[l] = GPIO_V2_LINE_FLAG_INPUT;
+			chip->lines++;
+		}
+		GPIOINDEX[i] = l;
+	}
+
+	if(cfd < 0) return NEO_EXPORT_ERROR;
+
+	if(chip->lines > 0) {
+		memset(&req, 0, sizeof(req));
+		memcpy(req.offsets, chip->offsets, sizeof(unsigned int) * chip->lines);
+		req.num_lines = chip->lines;
+		req.config.flags = GPIO_V2_LINE_FLAG_INPUT;
+		strcpy(req.consumer, GPIOCONSUMER);
+
+		if(ioctl(cfd, GPIO_V2_GET_LINE_IOCTL, &req) < 0) fail = NEO_UNUSABLE_ERROR;
+		else chip->fd = req.fd;
+	}
+
+	close(cfd);
+	return fail;
+}
+
+#endif
+
+//Maps all the gpio bank registers from the mmap source
+int __neo_regs_map() {
+	int mfd = open(neo_gpio_mmap_path, O_RDWR | O_SYNC | O_CLOEXEC);
+	if(mfd < 0) return NEO_EXPORT_ERROR;
+
+	void *regs = mmap(NULL, GPIOBANKL * GPIOMMAPSTRIDE, PROT_READ | PROT_WRITE,
+				MAP_SHARED, mfd, (off_t) neo_gpio_mmap_base);
+	close(mfd); //The mapping stays valid after closing
+
+	if(regs == MAP_FAILED) return NEO_EXPORT_ERROR;
+	neo_gpio_regs = (volatile uint32_t *) regs;
+	return NEO_OK;
+}
+
+//Exports a single pin to sysfs and opens its files, eFile can be NULL to open the export here
+int __neo_gpio_export(int pin, FILE *eFile) {
+	int fail = NEO_OK;
+	FILE *own = NULL;
+
+	if(eFile == NULL) eFile = own = fopen(EXPORTPATH, "w");
+	if(eFile == NULL) fail = NEO_EXPORT_ERROR;
+
+	//Check if opening of sysfs was a success and attempt to flush the new pin number
+	if(eFile != NULL) {
+		fprintf(eFile, "%s", GPIOPORTS[pin]);
+		fflush(eFile);
+	}
+	if(own != NULL) fclose(own);
+
+	//Calcuate total new path size to store in buffer
+	size_t newPathS = strlen(GPIOPORTS[pin]) + gpioL + valueL;
+	size_t newDPathS = strlen(GPIOPORTS[pin]) + gpioL + directionL;
+	size_t newEPathS = strlen(GPIOPORTS[pin]) + gpioL + edgeL;
+	size_t newAPathS = strlen(GPIOPORTS[pin]) + gpioL + activelowL;
+
+	//Create new path buffer for temporary storage
+	char buff[newPathS + 1];
+	char buffD[newDPathS + 1];
+	char buffE[newEPathS + 1];
+	char buffA[newAPathS + 1];
+
+	//Combine the current gpio path to buffer
+	sprintf(buff, "%s%s%s", GPIOPATH, GPIOPORTS[pin], VALUEPATH);
+	sprintf(buffD, "%s%s%s", GPIOPATH, GPIOPORTS[pin], DIRECTIONPATH);
+	sprintf(buffE, "%s%s%s", GPIOPATH, GPIOPORTS[pin], EDGEPATH);
+	sprintf(buffA, "%s%s%s", GPIOPATH, GPIOPORTS[pin], ACTIVELOWPATH);
+
+	//Open the value port pin and direction pins
+	gpioP[pin] = fopen(buff, "r+");
+	gpioD[pin] = fopen(buffD, "r+");
+	gpioE[pin] = fopen(buffE, "r+");
+	gpioA[pin] = fopen(buffA, "r+");
+
+	FILE *port_f = gpioP[pin];
+	FILE *direction_f = gpioD[pin];
+
+	//If failed to open the sysfs files make sure to print it's unusable
+	if(port_f == NULL || direction_f == NULL) {
+		fail = NEO_UNUSABLE_ERROR;
+	} else {
+		fprintf(direction_f, "%s", "in"); //Set all pins to input
+		fflush(direction_f); //Flush stream/buffer
+	}
 	
-	g_io_channel_seek_position(ch, 0, G_SEEK_SET, 0); //Set data buffer seek to 0
-	GIOStatus gs = g_io_channel_read_chars(ch, r_buff, buf_r_size - 1, &current_read, &err);
+	FILE *edge = gpioE[pin];
+	FILE *activelow = gpioA[pin];
 	
-	//if((int) gs != 1) { //Check for errors
-	int f_data; //Store data from interrupt event
-	int cr = sscanf(r_buff, "%d", &f_data); //Load the gchar array into the int
+	if(edge != NULL) { //Check that the pin supports interrupts
+		fprintf(edge, "%s", "none"); //Set to no interrupt detection
+		fflush(edge); //Flush buffer
+	}
 	
-	if(cr < 1) { //On data recieve failed
-		f_data = NEO_FAIL; //Set failure flag
+	if(activelow != NULL) { //Check that the pin supports active_low
+		fprintf(activelow, "%s", "0"); //Set to default pull down resistor
+		fflush(activelow); //Flush buffer
+	}
+
+	return fail;
+}
+
+//Opens a pin on the selected backend, on chardev the whole bank of the pin is opened
+int __neo_gpio_open(int pin, FILE *eFile) {
+	int i, ret;
+
+#ifdef GPIO_V2_GET_LINE_IOCTL
+	if(neo_gpio_backend == NEO_GPIO_CHARDEV) {
+		int bank = GPIOBANK[pin];
+		ret = __neo_chip_request(bank);
+
+		for(i = 0; i < GPIOPORTSL; i++) {
+			if(GPIOBANK[i] != bank) continue;
+			if(GPIOINDEX[i] < 0 || neo_gpio_chips[bank].fd < 0) {
+				USABLEGPIO[i] = 0;
+				if(ret == NEO_OK) ret = NEO_UNUSABLE_ERROR;
+			}
+			GPIOSET(OPENGPIO, i, 1); //Other threads can use it from here
+		}
+		return ret;
 	}
+#endif
 
-	if(USEDINT[t_inter.pinNum] < 1) {
-		USEDINT[t_inter.pinNum] += 1; //Update the usage
-		return 1; //Return a success
+	ret = __neo_gpio_export(pin, eFile);
+
+	//The registers don't need sysfs, it's only used for the interrupts there
+	if(neo_gpio_backend == NEO_GPIO_MMAP) {
+		pthread_mutex_lock(&neo_gpio_bank_locks[GPIOBANK[pin]]);
+		GPIOREG(GPIOBANK[pin], GPIOREGGDIR) &= ~(1U << GPIOLINE[pin]); //Start as input
+		pthread_mutex_unlock(&neo_gpio_bank_locks[GPIOBANK[pin]]);
+		ret = NEO_OK;
 	}
 
-	t_inter.intfunc(t_inter.pinNum, f_data);
-	//Call the user function with pinNumber and current flag
-		
-		
-	//} else printf("Interrupt error!\n");
-	return 1;	
+	if(ret == NEO_UNUSABLE_ERROR) USABLEGPIO[pin] = 0;
+	GPIOSET(OPENGPIO, pin, 1); //Other threads can use it from here
+	return ret;
 }
 
-//When the interrupt pin was failed or wasn't assigned by user, print dummy event
-void __neo_dummy_int_event(int pin, int data) {
-	printf("Dummy Interrupt Event(Pin: %d) -> Data: %d", pin, data);
+//Makes sure the pin was opened (lazy mode), returns NEO_OK when the pin is usable
+int __neo_gpio_ready(int pin) {
+	if(!GPIOGET(OPENGPIO, pin)) {
+		//The chardev opens the whole bank of the pin at once
+		pthread_mutex_t *lock = (neo_gpio_backend == NEO_GPIO_CHARDEV) ?
+			&neo_gpio_bank_locks[GPIOBANK[pin]] : &neo_gpio_locks[pin];
+
+		pthread_mutex_lock(lock);
+		if(!OPENGPIO[pin]) __neo_gpio_open(pin, NULL); //Someone else might have opened it meanwhile
+		pthread_mutex_unlock(lock);
+	}
+	return (USABLEGPIO[pin]) ? NEO_OK : NEO_UNUSABLE_ERROR;
 }
 
+//Writes the pin value through the selected backend (no checks, see neo_gpio_digital_write), NEO_WRITE_ERROR if the kernel refused
+int __neo_gpio_set_value(int pin, int value) {
+	if(neo_gpio_backend == NEO_GPIO_MMAP) {
+		pthread_mutex_lock(&neo_gpio_bank_locks[GPIOBANK[pin]]); //The whole bank shares the register
+		if(value) GPIOREG(GPIOBANK[pin], GPIOREGDR) |= (1U << GPIOLINE[pin]);
+		else GPIOREG(GPIOBANK[pin], GPIOREGDR) &= ~(1U << GPIOLINE[pin]);
+		pthread_mutex_unlock(&neo_gpio_bank_locks[GPIOBANK[pin]]);
+		__neo_vcd_record(pin, value, 0);
+		return NEO_OK;
+	}
+#ifdef GPIO_V2_GET_LINE_IOCTL
+	if(neo_gpio_backend == NEO_GPIO_CHARDEV) {
+		gpio_chip_t *chip = &neo_gpio_chips[GPIOBANK[pin]];
+		struct gpio_v2_line_values vals;
+		int ret;
+
+		vals.mask = 1ULL << GPIOINDEX[pin];
+		vals.bits = (value) ? vals.mask : 0;
+
+		//Keep the outputs in step with the request for __neo_chip_apply, only with what the line really got
+		pthread_mutex_lock(&neo_gpio_bank_locks[GPIOBANK[pin]]);
+		ret = ioctl(chip->fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &vals);
+		if(ret >= 0) chip->outputs = (chip->outputs & ~vals.mask) | vals.bits;
+		pthread_mutex_unlock(&neo_gpio_bank_locks[GPIOBANK[pin]]);
+		if(ret < 0) return NEO_WRITE_ERROR;
+		__neo_vcd_record(pin, value, 0);
+		return NEO_OK;
+	}
+#endif
+	//A single positioned write, there's no stream position for threads to fight over
+	if(pwrite(fileno(gpioP[pin]), (value) ? "1" : "0", 1, 0) < 0) return NEO_WRITE_ERROR;
+	__neo_vcd_record(pin, value, 0);
+	return NEO_OK;
+}
 
-//This will make sure all the interrupts have presets and don't crash after free
-void __neo_initialize_interrupts() {
-	int ind;
-	//Loop through each struct set default params
-	for(ind = 0; ind < GPIOPORTSL; ind++) {
-		interrupt_t t_temp = neo_gpio_interrupts[ind];
-		
-		//Set the default values and functions
-		t_temp.pinNum = 0;
-		t_temp.attached = 0;
-		t_temp.intfunc = &__neo_dummy_int_event;
+//Reads the pin value through the selected backend (no checks, see neo_gpio_digital_read)
+int __neo_gpio_get_value(int pin) {
+	if(neo_gpio_backend == NEO_GPIO_MMAP) {
+		//The pad status register holds the real level of input pins
+		return (GPIOREG(GPIOBANK[pin], GPIOREGPSR) >> GPIOLINE[pin]) & 1U;
+	}
+#ifdef GPIO_V2_GET_LINE_IOCTL
+	if(neo_gpio_backend == NEO_GPIO_CHARDEV) {
+		struct gpio_v2_line_values vals;
+
+		vals.mask = 1ULL << GPIOINDEX[pin];
+		vals.bits = 0;
+		if(ioctl(neo_gpio_chips[GPIOBANK[pin]].fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &vals) < 0) {
+			return NEO_READ_ERROR;
+		}
+		return (vals.bits & vals.mask) ? HIGH : LOW;
 	}
+#endif
+	char r_buff[3];
+
+	//A single positioned read, there's no stream position for threads to fight over
+	if(pread(fileno(gpioP[pin]), r_buff, sizeof(r_buff) - 1, 0) < 1) return NEO_READ_ERROR;
+	return (r_buff[0] == '1') ? HIGH : LOW;
 }
 
-//This is the backend thread start that will attach a pin to an interrupt
-void *__neo_attach_interrupt(void *arg) {
-	interrupt_t pin_fd;
-	pin_fd = (*(interrupt_t*)(arg)); //Parse argument as int
-	GMainLoop *loop = g_main_loop_new(0,0); //Create new watch loop
-	
-	GIOChannel *ch = g_io_channel_unix_new(pin_fd.fd); //Set up new channel for file descriptor
-	GIOCondition cond = G_IO_PRI; //Only wait for new data to arrive	
-	
-	//Attach the new loop with the channel on watch
-	guint id = g_io_add_watch(ch, cond, __neo_interrupt_event, &pin_fd);
-	
-	g_main_loop_run(loop); //Start the loop
+//Sets the direction through the selected backend (edge detection is turned off for outputs)
+//The caller holds the pin lock
+int __neo_gpio_set_dir(int pin, int direction) {
+#ifdef GPIO_V2_GET_LINE_IOCTL
+	if(neo_gpio_backend == NEO_GPIO_CHARDEV) {
+		gpio_chip_t *chip = &neo_gpio_chips[GPIOBANK[pin]];
+		uint64_t *flags = &chip->flags[GPIOINDEX[pin]];
+		int ret;
+
+		pthread_mutex_lock(&neo_gpio_bank_locks[GPIOBANK[pin]]);
+		//Keep the pull resistor settings only when staying an input
+		*flags = (direction == OUTPUT) ? GPIO_V2_LINE_FLAG_OUTPUT :
+			((*flags & ~(GPIO_V2_LINE_FLAG_OUTPUT | GPIO_V2_LINE_FLAG_EDGE_RISING |
+				GPIO_V2_LINE_FLAG_EDGE_FALLING)) | GPIO_V2_LINE_FLAG_INPUT);
+
+		ret = __neo_chip_apply(GPIOBANK[pin]);
+		pthread_mutex_unlock(&neo_gpio_bank_locks[GPIOBANK[pin]]);
+		return ret;
+	}
+#endif
+	if(neo_gpio_backend == NEO_GPIO_MMAP) {
+		FILE *edge = gpioE[pin]; //Turn off the edge if the pin was exported as well
+		if(edge != NULL && direction == OUTPUT) {
+			fseek(edge, 0, SEEK_SET);
+			fprintf(edge, "%s", NOEDGE);
+			fflush(edge);
+		}
+
+		pthread_mutex_lock(&neo_gpio_bank_locks[GPIOBANK[pin]]);
+		if(direction == OUTPUT) GPIOREG(GPIOBANK[pin], GPIOREGGDIR) |= (1U << GPIOLINE[pin]);
+		else GPIOREG(GPIOBANK[pin], GPIOREGGDIR) &= ~(1U << GPIOLINE[pin]);
+		pthread_mutex_unlock(&neo_gpio_bank_locks[GPIOBANK[pin]]);
+		return NEO_OK;
+	}
+
+	if(GPIOGET(DIRGPIO, pin) == (unsigned char) INPUT && direction == OUTPUT) { 
+		FILE *edge = gpioE[pin]; //Make sure the edge is off to switch to output
+		if(edge == NULL) return NEO_INTERRUPT_ERROR;
+		fseek(edge, 0, SEEK_SET); //Set seek to beginning
+		fprintf(edge, "%s", NOEDGE); //Update the edge
+		fflush(edge); //Flush the stream
+	}
+
+	//Select direction of the pin
+	FILE *curD = gpioD[pin];
+	fseek(curD, 0, SEEK_SET);
+	//Set to INPUT "in" or OUTPUT "out"
+	fprintf(curD, "%s", (direction == INPUT) ? "in" : "out");
+	fflush(curD);
+	return NEO_OK;
 }
 
-//Thread main loop managers for the pin interrupts
-pthread_t gpioINTS_T[GPIOPORTSL + 2];
+//Sets the pull resistor of an input pin, HIGH for pull up and LOW for pull down
+//The caller holds the pin lock
+int __neo_gpio_set_pull(int pin, int value) {
+#ifdef GPIO_V2_GET_LINE_IOCTL
+	if(neo_gpio_backend == NEO_GPIO_CHARDEV) {
+		uint64_t *flags = &neo_gpio_chips[GPIOBANK[pin]].flags[GPIOINDEX[pin]];
+		int ret;
+
+		pthread_mutex_lock(&neo_gpio_bank_locks[GPIOBANK[pin]]);
+		*flags &= ~(GPIO_V2_LINE_FLAG_BIAS_PULL_UP | GPIO_V2_LINE_FLAG_BIAS_PULL_DOWN);
+		*flags |= (value) ? GPIO_V2_LINE_FLAG_BIAS_PULL_UP : GPIO_V2_LINE_FLAG_BIAS_PULL_DOWN;
+		ret = __neo_chip_apply(GPIOBANK[pin]);
+		pthread_mutex_unlock(&neo_gpio_bank_locks[GPIOBANK[pin]]);
+		return ret;
+	}
+#endif
+	FILE *active = gpioA[pin]; //Get the pullup resistor
+	if(active == NULL) return NEO_UNUSABLE_ERROR;
+	fseek(active, 0, SEEK_SET);
+	fprintf(active, "%d", value); //Set the pullup or pulldown direction
+	fflush(active); //Update stream
+	return NEO_OK;
+}
 
 //Handle freeing all of the functions
 void neo_free_all() {
@@ -176,6 +501,41 @@ void neo_free_all() {
 }
 
 
+//Sets the edge detection of an input pin through the selected backend (NOEDGE, RISINGEDGE...)
+int __neo_gpio_set_edge(int pin, const char *mode) {
+#ifdef GPIO_V2_GET_LINE_IOCTL
+	if(neo_gpio_backend == NEO_GPIO_CHARDEV) {
+		uint64_t *flags = &neo_gpio_chips[GPIOBANK[pin]].flags[GPIOINDEX[pin]];
+		int ret;
+
+		pthread_mutex_lock(&neo_gpio_bank_locks[GPIOBANK[pin]]);
+		*flags &= ~(GPIO_V2_LINE_FLAG_EDGE_RISING | GPIO_V2_LINE_FLAG_EDGE_FALLING);
+		if(strcmp(mode, RISINGEDGE) == 0 || strcmp(mode, BOTHEDGE) == 0) *flags |= GPIO_V2_LINE_FLAG_EDGE_RISING;
+		if(strcmp(mode, FALLINGEDGE) == 0 || strcmp(mode, BOTHEDGE) == 0) *flags |= GPIO_V2_LINE_FLAG_EDGE_FALLING;
+		ret = __neo_chip_apply(GPIOBANK[pin]);
+		pthread_mutex_unlock(&neo_gpio_bank_locks[GPIOBANK[pin]]);
+		return (ret == NEO_OK) ? NEO_OK : NEO_INTERRUPT_ERROR;
+	}
+#endif
+	FILE *edge = gpioE[pin];
+	if(edge == NULL) return NEO_INTERRUPT_ERROR;
+
+	pthread_mutex_lock(&neo_gpio_locks[pin]);
+	fseek(edge, 0, SEEK_SET); //Set seek to beginning
+	fprintf(edge, "%s", mode); //Update the edge
+	fflush(edge); //Flush the stream
+	pthread_mutex_unlock(&neo_gpio_locks[pin]);
+	return NEO_OK;
+}
+
+//Gets the file descriptor that wakes up on the pin edges (the bank request on chardev)
+int __neo_gpio_edge_fd(int pin) {
+#ifdef GPIO_V2_GET_LINE_IOCTL
+	if(neo_gpio_backend == NEO_GPIO_CHARDEV) return neo_gpio_chips[GPIOBANK[pin]].fd;
+#endif
+	return (gpioP[pin] != NULL) ? fileno(gpioP[pin]) : -1;
+}
+
 #endif
 
 /**
@@ -183,7 +543,7 @@ void neo_free_all() {
  * 
  * Starts the gpio pins all having the direction of in and  are tested against
  * each other to see if the pin is available. For a fast usable gpio list. This can
- * be called multiple times safely.
+ * be called multiple times safely. This uses the sysfs backend @see neo_gpio_init_backend()
  * 
  * @return NEO_OK or NEO_EXPORT_ERROR/NEO_UNUSABLE_ERRROR if some GPIO weren't initialized
  * 
@@ -192,10 +552,46 @@ void neo_free_all() {
  */
 int neo_gpio_init() 
 {
-	int i, gi, fail;
+	return neo_gpio_init_backend(NEO_GPIO_SYSFS);
+}
+
+/**
+ * @brief Initializes the GPIO controller on a selected backend
+ * 
+ * Same as neo_gpio_init but lets you pick how the pins are accessed. NEO_GPIO_SYSFS
+ * is the classic /sys/class/gpio files (one stdio write per toggle). NEO_GPIO_CHARDEV
+ * requests every bank from /dev/gpiochipN once, and then every read or write is a single
+ * ioctl. The backend is fixed until neo_gpio_free is called, so call this before anything
+ * else initializes the gpio (Servo, FakePWM and the C++ classes call neo_gpio_init)
+ * NEO_GPIO_MMAP writes the bank registers directly, which is the fastest by far, but it
+ * skips the kernel completely. @see neo_gpio_set_mmap_source()
+ * 
+ * Add NEO_GPIO_LAZY to the backend (NEO_GPIO_SYSFS | NEO_GPIO_LAZY) to skip opening all 48 pins
+ * up front, a pin is then exported and opened the first time it's used (pin mode, read, write or
+ * interrupt). That is a lot faster to start for tools that only touch a couple of pins.
+ * 
+ * @param backend Either NEO_GPIO_SYSFS, NEO_GPIO_CHARDEV or NEO_GPIO_MMAP (optionally | NEO_GPIO_LAZY)
+ * @return NEO_OK or NEO_EXPORT_ERROR/NEO_UNUSABLE_ERRROR if some GPIO weren't initialized
+ * 
+ * @note The character device backend needs linux 5.10 or newer (uAPI v2)
+ * @note Pins exported to sysfs by another program can't be requested by the character device
+ * @note NEO_GPIO_MMAP needs root for /dev/mem, and still exports sysfs for the interrupts
+ */
+int neo_gpio_init_backend(int backend) 
+{
+	int i, gi, fail, lazy;
 
 	
 	fail = NEO_OK; //Return code
+	lazy = backend & NEO_GPIO_LAZY;
+	backend &= ~NEO_GPIO_LAZY;
+
+#ifdef GPIO_V2_GET_LINE_IOCTL
+	if(backend < NEO_GPIO_SYSFS || backend > NEO_GPIO_MMAP) return NEO_EXPORT_ERROR;
+#else
+	if(backend == NEO_GPIO_CHARDEV) return NEO_EXPORT_ERROR; //Built without the gpio v2 uAPI
+	if(backend < NEO_GPIO_SYSFS || backend > NEO_GPIO_MMAP) return NEO_EXPORT_ERROR;
+#endif
 
 	//Double check to not run twice
 	if(neo_gpio_freed == 2) {
@@ -205,75 +601,52 @@ int neo_gpio_init()
 			neo_exit_set = 1;
 		}
 	
-		//Set all the ports to usable
-		for(gi = 0; gi < GPIOPORTSL; gi++) {USABLEGPIO[gi] = 1; USEDINT[gi] = 0;}
-	
-		//Compile the export sysfs path
-		FILE *eFile;
-		eFile = fopen(EXPORTPATH, "w");
-		
-		if(eFile == NULL) fail = NEO_EXPORT_ERROR; //If couldn't export it failed
-	
-		//Initialize all the gpio ports by looping through available ones
-		for(i = 0; i < GPIOPORTSL; i++) { 
-	
-			//Check if opening of sysfs was a success and attempt to flush the new pin number
-			if(eFile != NULL) {
-				fprintf(eFile, "%s", GPIOPORTS[i]);
-				fflush(eFile);
-			}
-	
-			//Calcuate total new path size to store in buffer
-			size_t newPathS = strlen(GPIOPORTS[i]) + gpioL + valueL;
-			size_t newDPathS = strlen(GPIOPORTS[i]) + gpioL + directionL;
-			size_t newEPathS = strlen(GPIOPORTS[i]) + gpioL + edgeL;
-			size_t newAPathS = strlen(GPIOPORTS[i]) + gpioL + activelowL;
-	
-			//Create new path buffer for temporary storage
-			char buff[newPathS];
-			char buffD[newDPathS];
-			char buffE[newEPathS];
-			char buffA[newAPathS];
-	
-			//Combine the current gpio path to buffer
-			sprintf(buff, "%s%s%s", GPIOPATH, GPIOPORTS[i], VALUEPATH);
-			sprintf(buffD, "%s%s%s", GPIOPATH, GPIOPORTS[i], DIRECTIONPATH);
-			sprintf(buffE, "%s%s%s", GPIOPATH, GPIOPORTS[i], EDGEPATH);
-			sprintf(buffA, "%s%s%s", GPIOPATH, GPIOPORTS[i], ACTIVELOWPATH);
-	
-			//Open the value port pin and direction pins
-			gpioP[i] = fopen(buff, "r+");
-			gpioD[i] = fopen(buffD, "r+");
-			gpioE[i] = fopen(buffE, "r+");
-			gpioA[i] = fopen(buffA, "r+");
-	
-			FILE *port_f = gpioP[i];
-			FILE *direction_f = gpioD[i];
-	
-			//If failed to open the sysfs files make sure to print it's unusable
-			if(port_f == NULL || direction_f == NULL) {
-				fail = NEO_UNUSABLE_ERROR;
+		neo_gpio_backend = backend;
+
+		//Set all the ports to usable and map them to their bank and line
+		for(gi = 0; gi < GPIOPORTSL; gi++) {
+			USABLEGPIO[gi] = 1; 
+			OPENGPIO[gi] = 0;
+			GPIOBANK[gi] = atoi(GPIOPORTS[gi]) / GPIOBANKSIZE;
+			GPIOLINE[gi] = atoi(GPIOPORTS[gi]) % GPIOBANKSIZE;
+			GPIOINDEX[gi] = -1;
+			DIRGPIO[gi] = INPUT; //Set the global direction to 0 (input)
+			VALGPIO[gi] = LOW; //Set the global pin direction to 0 (low)
+			gpioP[gi] = gpioD[gi] = gpioE[gi] = gpioA[gi] = NULL;
+		}
+
+		for(i = 0; i < GPIOBANKL; i++) {
+			neo_gpio_chips[i].fd = -1;
+			neo_gpio_chips[i].lines = 0;
+		}
+
+		//The registers are mapped once either way, it's only one open
+		if(backend == NEO_GPIO_MMAP && __neo_regs_map() != NEO_OK) {
+			for(i = 0; i < GPIOPORTSL; i++) {
 				USABLEGPIO[i] = 0;
-			} else {
-				fprintf(direction_f, "%s", "in"); //Set all pins to input
-				fflush(direction_f); //Flush stream/buffer
+				OPENGPIO[i] = 1;
 			}
-			
-			DIRGPIO[i] = INPUT; //Set the global direction to 0 (input)
-			VALGPIO[i] = LOW; //Set the global pin direction to 0 (low)
-			
-			FILE *edge = gpioE[i];
-			FILE *activelow = gpioA[i];
-			
-			if(edge != NULL) { //Check that the pin supports interrupts
-				fprintf(edge, "%s", "none"); //Set to no interrupt detection
-				fflush(edge); //Flush buffer
+			fail = NEO_EXPORT_ERROR;
+			lazy = 1; //Nothing left to open
+		}
+
+		//In lazy mode the pins are opened on first use @see __neo_gpio_open
+		if(!lazy) {
+			//Compile the export sysfs path
+			FILE *eFile = NULL;
+			if(backend != NEO_GPIO_CHARDEV) {
+				eFile = fopen(EXPORTPATH, "w");
+				if(eFile == NULL && backend == NEO_GPIO_SYSFS) fail = NEO_EXPORT_ERROR; //If couldn't export it failed
 			}
-			
-			if(activelow != NULL) { //Check that the pin supports active_low
-				fprintf(activelow, "%s", "0"); //Set to default pull down resistor
-				fflush(activelow); //Flush buffer
+
+			//Initialize all the gpio ports by looping through available ones
+			for(i = 0; i < GPIOPORTSL; i++) { 
+				if(OPENGPIO[i]) continue; //The chardev banks open many pins at once
+				int ret = __neo_gpio_open(i, eFile);
+				if(ret != NEO_OK && fail == NEO_OK) fail = ret;
 			}
+
+			if(eFile != NULL) fclose(eFile);
 		}
 		
 		__neo_initialize_interrupts(); //Setup interrupt structs
@@ -284,6 +657,28 @@ int neo_gpio_init()
 	return fail;
 }
 
+/**
+ * @brief Sets where the gpio bank registers are mapped from
+ * 
+ * The NEO_GPIO_MMAP backend maps the seven i.MX6 gpio banks (DR, GDIR and PSR registers)
+ * from /dev/mem at 0x0209C000 by default. Any file can be used instead, as long as it holds
+ * seven 0x4000 byte banks starting at the base offset. This way the register logic can be run
+ * against a plain file on any linux box. Must be called before neo_gpio_init_backend
+ * 
+ * @param path The file to map the registers from (NULL keeps the current one)
+ * @param base The byte offset of the first bank in that file (must be page aligned)
+ * @return NEO_OK or NEO_FAIL if the gpio is already initialized or the path is too long
+ */
+int neo_gpio_set_mmap_source(const char *path, unsigned long base) {
+	if(neo_gpio_freed != 2) return NEO_FAIL; //Can't move the registers while in use
+	if(path != NULL) {
+		if(strlen(path) >= sizeof(neo_gpio_mmap_path)) return NEO_FAIL;
+		strcpy(neo_gpio_mmap_path, path);
+	}
+	neo_gpio_mmap_base = base;
+	return NEO_OK;
+}
+
 /**
  * @brief Sets the direction of the pin
  * 
@@ -299,71 +694,16 @@ int neo_gpio_init()
 int neo_gpio_pin_mode(int pin, int direction) {
 	//Safety check to see if both arguments are valid
 	if(direction < 0 || direction > 1) return NEO_DIR_ERROR;
-	if(pin < 0 || pin > GPIOPORTSL) return NEO_PIN_ERROR;
-
-	if(DIRGPIO[pin] == (unsigned char) INPUT && direction == OUTPUT) { 
-		FILE *edge = gpioE[pin]; //Make sure the edge is off to switch to output
-		if(edge == NULL || !USABLEGPIO[pin]) return NEO_INTERRUPT_ERROR;
-		fseek(edge, 0, SEEK_SET); //Set seek to beginning
-		fprintf(edge, "%s", NOEDGE); //Update the edge
-		fflush(edge); //Flush the stream
-	}
-
-	//Select direction of the pin
-	FILE *curD = gpioD[pin];
-	if(curD == NULL || !USABLEGPIO[pin]) return NEO_UNUSABLE_ERROR;
-	fseek(curD, 0, SEEK_SET);
-	//Set to INPUT "in" or OUTPUT "out"
-	fprintf(curD, "%s", (direction == 0) ? "in" : "out");
-	fflush(curD);
-	
-	DIRGPIO[pin] = (unsigned char) direction;
-	
-	return NEO_OK; //On success
-}
-
-/**
- * @brief Attaches an interrupt to a pin
- * 
- * This will start a new thread that listens for a pin change state based on what you want
- * A state of either "rising" to only detect when the pin changes from 0 to 1. "falling" for the
- * function to only call from 1 to 0 and "both" that happens if it changes either way.
- * 
- * @return NEO_OK/NEO_INTERRUPT_ERROR/NEO_PIN_ERROR/NEO_UNUSABLE_ERRROR if the interrupt failed
- * @param pin The pin to attach the interrupt to
- * @param mode The mode to put the pin in available ("both", "rising", "falling")
- * @param intfunc The function pointer to the interrupt return
- */
-int neo_gpio_attach_interrupt(int pin, const char * mode, interruptfunc intfunc) {
-	//Safety check to see if both arguments are valid
-	if(strcmp(mode, "both") != 0 && strcmp(mode, "rising") != 0 
-				&& strcmp(mode, "falling") != 0) return NEO_INTERRUPT_ERROR;
-	if(pin < 0 || pin > GPIOPORTSL) return NEO_PIN_ERROR;
-	if(intfunc == NULL) return NEO_INTERRUPT_ERROR;
-
-	//If the pin is output, set the pin to input and setup the edge
-	if(DIRGPIO[pin] == (unsigned char) OUTPUT) { 
-		int ret = neo_gpio_pin_mode(pin, INPUT);
-		
-		if(ret != NEO_OK) return ret;
-	}
-	
-	FILE *edge = gpioE[pin]; //Make sure the edge is off to switch to output
-	if(edge == NULL || !USABLEGPIO[pin]) return NEO_INTERRUPT_ERROR;
-	fseek(edge, 0, SEEK_SET); //Set seek to beginning
-	fprintf(edge, "%s", mode); //Update the edge
-	fflush(edge); //Flush the stream
-	
-	interrupt_t temp_int = neo_gpio_interrupts[pin];
-	temp_int.pinNum = pin;
-	temp_int.attached = 1;
-	temp_int.intfunc = intfunc;
-	temp_int.fd = fileno(gpioP[pin]);
-	neo_gpio_interrupts[pin] = temp_int;
-	
-	pthread_create(&gpioINTS_T[pin], NULL, __neo_attach_interrupt, &neo_gpio_interrupts[pin]);
+	if(pin < 0 || pin >= GPIOPORTSL) return NEO_PIN_ERROR;
+	if(__neo_gpio_ready(pin) != NEO_OK) return NEO_UNUSABLE_ERROR;
+
+	//Keep the pin and it's shadow direction in step
+	pthread_mutex_lock(&neo_gpio_locks[pin]);
+	int ret = __neo_gpio_set_dir(pin, direction);
+	if(ret == NEO_OK) GPIOSET(DIRGPIO, pin, direction);
+	pthread_mutex_unlock(&neo_gpio_locks[pin]);
 	
-	return NEO_OK; //On success
+	return ret; //NEO_OK on success
 }
 
 #ifndef DOXYGEN_SKIP
@@ -374,14 +714,7 @@ int neo_gpio_attach_interrupt(int pin, const char * mode, interruptfunc intfunc)
  * has been created is for the speed of the FAKE PWM MANAGER
  */
 int neo_gpio_digital_write_no_safety(int *pin, int direction) {
-	char toPut[2];
-	FILE *curP = gpioP[(*pin)];
-	
-	//Reload seek to cursor set 0 and write current direction
-	fseek(curP, 0, SEEK_SET);
-	sprintf(toPut, "%d", direction);
-	fputc(toPut[0], curP);
-	fflush(curP);
+	return __neo_gpio_set_value(*pin, direction);
 }
 
 #endif
@@ -392,7 +725,7 @@ int neo_gpio_digital_write_no_safety(int *pin, int direction) {
  * This will set the board pin to either a low or high state. Low will be 0 volts and 
  * high will be roughly 3.3v. Since this board works on 3.3v don't use 5v as an input!
  * 
- * @return NEO_OK or NEO_DIR_ERROR/NEO_PIN_ERROR/NEO_UNUSABLE_ERROR if some GPIO write failed
+ * @return NEO_OK or NEO_DIR_ERROR/NEO_PIN_ERROR/NEO_UNUSABLE_ERROR/NEO_WRITE_ERROR if some GPIO write failed
  * 
  * @note You must call neo_gpio_pin_mode(<pin>, OUTPUT); before writing
  * @warning Do not use 5v with these boards! It will ruin the board
@@ -400,26 +733,24 @@ int neo_gpio_digital_write_no_safety(int *pin, int direction) {
 int neo_gpio_digital_write(int pin, int direction) {
 	//Safety check to see if both arguments are correct
 	if(direction < 0 || direction > 1) return NEO_DIR_ERROR;
-	if(pin < 0 || pin > GPIOPORTSL) return NEO_PIN_ERROR;
-
-	if(DIRGPIO[pin] == (unsigned char) INPUT) {
-		FILE *active = gpioA[pin]; //Get the pullup resistor
-		fprintf(active, "%d", direction); //Set the pullup or pulldown direction
-		fflush(active); //Update stream
-		VALGPIO[pin] = (unsigned char) direction; //Set the direction currently
-		return NEO_OK;					
-	}
-
-
-	FILE *curP = gpioP[pin];
+	if(pin < 0 || pin >= GPIOPORTSL) return NEO_PIN_ERROR;
 
 	//Check USABLEGPIO pin
-	if(curP == NULL || !USABLEGPIO[pin]) return NEO_UNUSABLE_ERROR;
+	if(__neo_gpio_ready(pin) != NEO_OK) return NEO_UNUSABLE_ERROR;
+
+	if(GPIOGET(DIRGPIO, pin) == (unsigned char) INPUT) {
+		pthread_mutex_lock(&neo_gpio_locks[pin]);
+		int ret = __neo_gpio_set_pull(pin, direction); //Set the pullup or pulldown direction
+		if(ret == NEO_OK) GPIOSET(VALGPIO, pin, direction); //Set the direction currently
+		pthread_mutex_unlock(&neo_gpio_locks[pin]);
+		return ret;
+	}
 
 	//Above method to write to the GPIO (Safety check already done)
-	neo_gpio_digital_write_no_safety(&pin, direction);
+	int ret = neo_gpio_digital_write_no_safety(&pin, direction);
+	if(ret != NEO_OK) return ret; //The pin kept it's old value
 
-	VALGPIO[pin] = (unsigned char) direction;
+	GPIOSET(VALGPIO, pin, direction);
 
 	return NEO_OK;
 }
@@ -433,27 +764,179 @@ int neo_gpio_digital_write(int pin, int direction) {
  * @return NEO_OK or NEO_READ_ERROR/NEO_PIN_ERROR/NEO_UNUSABLE_ERROR if some GPIO read failed
  * 
  * @note You must call neo_gpio_pin_mode(<pin>, INPUT); before reading 
+ * @note Cached pins are answered without a syscall @see neo_gpio_set_cached()
  * @warning Do not use 5v with these boards! It will ruin the board
  */
 int neo_gpio_digital_read(int pin) {
 
 	//Safety check for the pin
-	if(pin < 0 || pin > GPIOPORTSL) return NEO_PIN_ERROR;
+	if(pin < 0 || pin >= GPIOPORTSL) return NEO_PIN_ERROR;
 
 	//You can't read it unless it's INPUT so just return the last known value
-	if(DIRGPIO[pin] == (unsigned char) OUTPUT) {
-		return VALGPIO[pin];
+	if(GPIOGET(DIRGPIO, pin) == (unsigned char) OUTPUT) {
+		return GPIOGET(VALGPIO, pin);
 	}
 
-	FILE *curP = gpioP[pin];
+	//The dispatcher keeps the level of cached pins, no need to ask the kernel
+	int cached = __neo_interrupt_cached(pin);
+	if(cached != NEO_FAIL) return cached;
 
-	if(curP == NULL || !USABLEGPIO[pin]) return NEO_UNUSABLE_ERROR;
+	if(__neo_gpio_ready(pin) != NEO_OK) return NEO_UNUSABLE_ERROR;
 
-	int dir;
-	fflush(curP); //Update buffer
-	fseek(curP, 0, SEEK_SET);
-	if(fscanf(gpioP[pin], "%d", &dir) == EOF) return NEO_READ_ERROR; //Read single digit
-	return dir;
+	return __neo_gpio_get_value(pin);
+}
+
+/**
+ * @brief Writes many gpio pins at once
+ * 
+ * Sets every pin in the mask to the value of the same bit in values (bit n is gpio pin n).
+ * The pins are grouped by the bank they are on and each bank is written at once, one ioctl
+ * with NEO_GPIO_CHARDEV or one register write with NEO_GPIO_MMAP. So pins on the same bank
+ * change at the same time. The sysfs backend has no bulk write and writes them one by one.
+ * 
+ * @param mask The pins to write (bit n is gpio pin n)
+ * @param values The values to write to those pins
+ * @return NEO_OK or NEO_DIR_ERROR/NEO_PIN_ERROR/NEO_UNUSABLE_ERROR if a pin can't be written, NEO_WRITE_ERROR if the kernel refused the write
+ * 
+ * @note Every pin in the mask must be set to OUTPUT first, nothing is written otherwise
+ */
+int neo_gpio_write_mask(uint64_t mask, uint64_t values) {
+	uint64_t banks[GPIOBANKL], bankv[GPIOBANKL];
+	int pin, b;
+
+	if(mask >> GPIOPORTSL) return NEO_PIN_ERROR; //Bits above the last pin
+
+	memset(banks, 0, sizeof(banks));
+	memset(bankv, 0, sizeof(bankv));
+
+	//Check every pin before writing anything so the write is all or nothing
+	for(pin = 0; pin < GPIOPORTSL; pin++) {
+		if(!((mask >> pin) & 1ULL)) continue;
+		if(__neo_gpio_ready(pin) != NEO_OK) return NEO_UNUSABLE_ERROR;
+		if(GPIOGET(DIRGPIO, pin) != (unsigned char) OUTPUT) return NEO_DIR_ERROR;
+
+		//The mmap banks are by line and the chardev banks are by request index
+		int bit = (neo_gpio_backend == NEO_GPIO_CHARDEV) ? GPIOINDEX[pin] : GPIOLINE[pin];
+		banks[GPIOBANK[pin]] |= (1ULL << bit);
+		if((values >> pin) & 1ULL) bankv[GPIOBANK[pin]] |= (1ULL << bit);
+		else bankv[GPIOBANK[pin]] &= ~(1ULL << bit);
+	}
+
+	if(neo_gpio_backend == NEO_GPIO_SYSFS) {
+		for(pin = 0; pin < GPIOPORTSL; pin++) {
+			if(((mask >> pin) & 1ULL) && __neo_gpio_set_value(pin, (values >> pin) & 1ULL) != NEO_OK) return NEO_WRITE_ERROR;
+		}
+	}
+
+	for(b = 0; b < GPIOBANKL; b++) {
+		if(banks[b] == 0) continue;
+
+		if(neo_gpio_backend == NEO_GPIO_MMAP) {
+			pthread_mutex_lock(&neo_gpio_bank_locks[b]);
+			uint32_t dr = GPIOREG(b, GPIOREGDR);
+			GPIOREG(b, GPIOREGDR) = (dr & ~((uint32_t) banks[b])) | (uint32_t) bankv[b];
+			pthread_mutex_unlock(&neo_gpio_bank_locks[b]);
+		}
+#ifdef GPIO_V2_GET_LINE_IOCTL
+		else if(neo_gpio_backend == NEO_GPIO_CHARDEV) {
+			gpio_chip_t *chip = &neo_gpio_chips[b];
+			struct gpio_v2_line_values vals;
+			int ret;
+
+			vals.mask = banks[b];
+			vals.bits = bankv[b];
+			pthread_mutex_lock(&neo_gpio_bank_locks[b]);
+			ret = ioctl(chip->fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &vals);
+			if(ret >= 0) chip->outputs = (chip->outputs & ~vals.mask) | vals.bits;
+			pthread_mutex_unlock(&neo_gpio_bank_locks[b]);
+			if(ret < 0) return NEO_WRITE_ERROR;
+		}
+#endif
+	}
+
+	//Update the known values, the banks changed at once so they share a timestamp
+	uint64_t ts = __neo_vcd_stamp();
+	for(pin = 0; pin < GPIOPORTSL; pin++) {
+		if(!((mask >> pin) & 1ULL)) continue;
+		GPIOSET(VALGPIO, pin, (values >> pin) & 1ULL);
+		if(neo_gpio_backend != NEO_GPIO_SYSFS) __neo_vcd_record(pin, (values >> pin) & 1ULL, ts); //Sysfs recorded each write
+	}
+
+	return NEO_OK;
+}
+
+#ifndef DOXYGEN_SKIP
+
+//Reads the pins in mask into a bitmap, only the banks that hold an input of the mask are read
+int __neo_gpio_sample(uint64_t mask, uint64_t *bits) {
+	uint64_t banks[GPIOBANKL], snap = 0;
+	unsigned int need = 0;
+	int pin, b;
+
+	for(pin = 0; pin < GPIOPORTSL; pin++) {
+		if(((mask >> pin) & 1ULL) && GPIOGET(DIRGPIO, pin) == (unsigned char) INPUT) need |= (1U << GPIOBANK[pin]);
+	}
+
+	//Sample each bank once
+	for(b = 0; b < GPIOBANKL; b++) {
+		if(!((need >> b) & 1U)) continue;
+
+		if(neo_gpio_backend == NEO_GPIO_MMAP) {
+			banks[b] = GPIOREG(b, GPIOREGPSR);
+		}
+#ifdef GPIO_V2_GET_LINE_IOCTL
+		else if(neo_gpio_backend == NEO_GPIO_CHARDEV && neo_gpio_chips[b].fd >= 0) {
+			struct gpio_v2_line_values vals;
+
+			vals.mask = (neo_gpio_chips[b].lines >= 64) ? ~0ULL : ((1ULL << neo_gpio_chips[b].lines) - 1);
+			vals.bits = 0;
+			if(ioctl(neo_gpio_chips[b].fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &vals) < 0) return NEO_READ_ERROR;
+			banks[b] = vals.bits;
+		}
+#endif
+	}
+
+	for(pin = 0; pin < GPIOPORTSL; pin++) {
+		int val;
+
+		if(!((mask >> pin) & 1ULL)) continue;
+		if(!GPIOGET(OPENGPIO, pin) || !USABLEGPIO[pin]) continue; //Lazy pins that were never used are LOW
+
+		if(GPIOGET(DIRGPIO, pin) == (unsigned char) OUTPUT) val = GPIOGET(VALGPIO, pin);
+		else if(neo_gpio_backend == NEO_GPIO_MMAP) val = (banks[GPIOBANK[pin]] >> GPIOLINE[pin]) & 1ULL;
+		else if(neo_gpio_backend == NEO_GPIO_CHARDEV) val = (banks[GPIOBANK[pin]] >> GPIOINDEX[pin]) & 1ULL;
+		else {
+			val = __neo_gpio_get_value(pin);
+			if(val < 0) return val;
+		}
+
+		if(val) snap |= (1ULL << pin);
+	}
+
+	*bits = snap;
+	return NEO_OK;
+}
+
+#endif
+
+/**
+ * @brief Reads every gpio pin at once into a bitmap
+ * 
+ * Takes a snapshot of all the pins (bit n is gpio pin n). Each bank is read with a single
+ * call, one GET_VALUES ioctl with NEO_GPIO_CHARDEV or one pad status register read with
+ * NEO_GPIO_MMAP, so all the pins of a bank are sampled at the same instant. Output pins
+ * give their last written value like neo_gpio_digital_read does and unusable pins (or lazy
+ * pins that were never used) are LOW.
+ * The sysfs backend has no bulk read, so it still reads the input pins one by one.
+ * 
+ * @param bits Where to store the bitmap of the pins
+ * @return NEO_OK or NEO_READ_ERROR/NEO_UNUSABLE_ERROR if a bank failed to read
+ */
+int neo_gpio_read_all(uint64_t *bits) {
+	if(bits == NULL) return NEO_READ_ERROR;
+	if(neo_gpio_freed != 0) return NEO_UNUSABLE_ERROR;
+
+	return __neo_gpio_sample(~0ULL, bits);
 }
 
 /**
@@ -472,9 +955,39 @@ int neo_gpio_free()
 	fail = NEO_OK;
 
 	if(neo_gpio_freed == 0) {
+		neo_seq_stop(NULL); //Nothing may touch the pins once they're closed
+		neo_analyzer_stop(NULL);
+		neo_vcd_stop(NULL);
+		__neo_ramp_free(NEO_RAMP_FAKE_PWM); //Writes the fake pwm channels
+		__neo_fake_pwm_free();
+		__neo_interrupt_free(); //Stop the dispatcher before closing its files
+
+#ifdef GPIO_V2_GET_LINE_IOCTL
+		if(neo_gpio_backend == NEO_GPIO_CHARDEV) {
+			//Releasing the line requests hands the lines back to the kernel
+			for(i = 0; i < GPIOBANKL; i++) {
+				if(neo_gpio_chips[i].fd >= 0) close(neo_gpio_chips[i].fd);
+				else if(neo_gpio_chips[i].lines > 0) fail = NEO_UNUSABLE_ERROR;
+				neo_gpio_chips[i].fd = -1;
+			}
+		}
+#endif
+
+		if(neo_gpio_backend == NEO_GPIO_MMAP) {
+			if(neo_gpio_regs != NULL) munmap((void *) neo_gpio_regs, GPIOBANKL * GPIOMMAPSTRIDE);
+			neo_gpio_regs = NULL;
+
+			//Only the pins that were exported have files to close
+			for(i = 0; i < GPIOPORTSL; i++) {
+				if(gpioP[i] != NULL) fclose(gpioP[i]);
+				if(gpioD[i] != NULL) fclose(gpioD[i]);
+				if(gpioE[i] != NULL) fclose(gpioE[i]);
+				if(gpioA[i] != NULL) fclose(gpioA[i]);
+			}
+		}
 
 		for(i = 0; i < GPIOPORTSL; i++) {
-			if(USABLEGPIO[i]) {
+			if(OPENGPIO[i] && USABLEGPIO[i] && neo_gpio_backend == NEO_GPIO_SYSFS) {
 				FILE *curP = gpioP[i];
 				FILE *curD = gpioD[i];
 				FILE *curE = gpioE[i];
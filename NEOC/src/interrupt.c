@@ -0,0 +1,1204 @@
+/*----------------------------------------------------------------------||
+|                                                                        |
+| Copyright (C) 2016 by David Smerkous                                   |
+| License Date: 11/27/2016                                               |
+| Modifiers: none                                                        |
+|                                                                        |
+| NEOC (libneo) is free software: you can redistribute it and/or modify  |
+|   it under the terms of the GNU General Public License as published by |
+|   the Free Software Foundation, either version 3 of the License, or    |
+|   (at your option) any later version.                                  |
+|                                                                        |
+| NEOC (libneo) is distributed in the hope that it will be useful,       |
+|   but WITHOUT ANY WARRANTY; without even the implied warranty of       |
+|   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        |
+|   GNU General Public License for more details.                         |
+|                                                                        |
+| You should have received a copy of the GNU General Public License      |
+|   along with this program.  If not, see http://www.gnu.org/licenses/   |
+|                                                                        |
+||----------------------------------------------------------------------*/
+
+/**
+ * 
+ * @file interrupt.c
+ * @author David Smerkous
+ * @date 11/28/2016
+ * @brief The gpio interrupt engine, one dispatcher thread for every attached pin
+ *
+ * @details All the attached pins are watched by a single thread with epoll. On sysfs
+ * (and mmap) that's the value file of each pin with EPOLLPRI, on the character device
+ * backend it's the line request of the bank. So attaching 20 pins still only costs one thread
+ * 
+ * Pins can be debounced in the dispatcher @see neo_gpio_set_debounce(), only the validated
+ * transitions reach the callbacks and the ring, the deadlines are kept with one timerfd.
+ * Every edge is also pushed with its timestamp into a lock-free ring (the dispatcher is the only
+ * producer) that can be drained in batches with neo_gpio_poll_events()
+ * 
+ * Pins in capture mode get their pulse widths measured from the raw edge timestamps @see neo_gpio_set_capture()
+ * and cached pins are read from the last level the dispatcher saw instead of the kernel @see neo_gpio_set_cached()
+ * Counted pins only cost one atomic add per edge @see neo_gpio_set_counter()
+ *
+ * @note The callbacks are called in order on a second thread fed by the dispatcher, so a slow
+ * callback can only delay other callbacks and never the timestamps of the edges
+ */
+
+#define _GNU_SOURCE //For ppoll
+
+#include <neo.h>
+
+#ifndef DOXYGEN_SKIP
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <poll.h>
+#include <linux/gpio.h>
+
+struct interrupt_h {
+	int pinNum; //Currently handled pin number
+	int attached; //If pin is attached to interrupt
+	int fd; //File descriptor for watcher
+	int cached; //If reads of the pin are answered with level @see neo_gpio_set_cached()
+	int level; //Last raw level seen by the dispatcher
+	int edge; //The edge the kernel reports (INTEDGE*)
+	int counting; //The edges counted (INTEDGE*, INTEDGENONE is off) @see neo_gpio_set_counter()
+	uint64_t count; //Edges counted since the last read
+	int waiting; //Set while a thread is in neo_gpio_wait_edge() on the pin
+	int waitfd; //Eventfd the dispatcher wakes that thread with (character device backend only, -1 otherwise)
+	uint64_t waitstart, waited; //When the wait started and the time of the edge handed to it (0 is none yet)
+	
+	interruptfunc intfunc; //The callback function to handle attachment
+};
+
+//Declare alias for struct
+typedef struct interrupt_h interrupt_t;
+
+struct debounce_h {
+	uint64_t stable; //Minimum time between two reported transitions (ns)
+	uint64_t glitch; //Minimum time a new level has to be held before it's believed (ns)
+
+	int level; //Last raw level seen
+	int reported; //Last level handed to the callback
+	uint64_t last; //Time of the last raw edge
+	uint64_t lock; //No transition is reported before this
+	uint64_t deadline; //When to look at the pin again (0 is never)
+
+	uint64_t edges; //Raw edges seen
+	uint64_t reports; //Transitions that made it through
+};
+
+//Declare alias for struct
+typedef struct debounce_h debounce_t;
+
+struct capture_h {
+	int window; //Periods asked for by the user (0 is off)
+	int reset; //Set by the user when the window changed
+
+	//Only touched by the dispatcher
+	int size; //Periods in the window in use
+	int level; //Last raw level (-1 is unknown)
+	uint64_t last; //Time of the last raw edge
+	uint64_t high[CAPTUREL], low[CAPTUREL]; //Widths of the last pulses (ns)
+	int hn, ln, hi, li; //Amount and next slot of each
+	uint64_t hsum, lsum; //Running sums of each
+
+	//Published to neo_gpio_capture_stats through the seqlock
+	unsigned int seq;
+	uint64_t pub_hsum, pub_hn, pub_lsum, pub_ln, pub_last;
+};
+
+//Declare alias for struct
+typedef struct capture_h capture_t;
+
+struct callback_h {
+	int pin;
+	int value;
+};
+
+//Declare alias for struct
+typedef struct callback_h callback_t;
+
+//Interrupt state of every gpio pin
+interrupt_t neo_gpio_interrupts[GPIOPORTSL];
+
+//Debounce state of every gpio pin, only the windows and counters are touched outside the dispatcher
+debounce_t neo_gpio_debounce[GPIOPORTSL];
+
+//Capture state of every gpio pin
+capture_t neo_gpio_capture[GPIOPORTSL];
+
+//The dispatcher thread, it's epoll, the eventfd that stops it and the debounce timer
+pthread_t neo_int_thread;
+int neo_int_epoll = -1;
+int neo_int_wake = -1;
+int neo_int_timer = -1;
+
+//The callback thread and the eventfd the dispatcher kicks it with
+pthread_t neo_int_cbthread;
+int neo_int_cbwake = -1;
+int neo_int_stop = 0;
+int neo_int_threads = 0; //Which of the threads are running
+
+//How many attached or waited on pins use each bank request (character device backend only)
+int neo_int_banks[GPIOBANKL];
+
+//Serializes starting and stopping the engine, the attaches, the detaches and the bank counts
+pthread_mutex_t neo_int_lock = PTHREAD_MUTEX_INITIALIZER;
+unsigned int neo_int_runs = 0; //Goes up every time the engine is stopped
+
+//Keeps the eventfd of a waiter open while the dispatcher writes to it
+pthread_mutex_t neo_int_wait_lock = PTHREAD_MUTEX_INITIALIZER;
+
+//Edge ring, the head is only moved by the dispatcher and the tail only by neo_gpio_poll_events
+neo_gpio_event_t neo_int_ring[INTRINGL];
+uint64_t neo_int_head = 0;
+uint64_t neo_int_tail = 0;
+uint64_t neo_int_seq = 0; //Counts every edge, even the ones dropped on a full ring
+
+//Callback queue from the dispatcher to the callback thread, same single producer single consumer as above
+callback_t neo_int_calls[INTRINGL];
+uint64_t neo_int_call_head = 0;
+uint64_t neo_int_call_tail = 0;
+
+const int buf_r_size = 3; //3 char buffer max (to be generous to the reading)
+
+//When the interrupt pin was failed or wasn't assigned by user, print dummy event
+void __neo_dummy_int_event(int pin, int data) {
+	printf("Dummy Interrupt Event(Pin: %d) -> Data: %d", pin, data);
+}
+
+//Pushes an edge into the ring, drops it when the consumer is too far behind
+void __neo_interrupt_push(int pin, int value, uint64_t ts) {
+	uint64_t head = __atomic_load_n(&neo_int_head, __ATOMIC_RELAXED);
+	uint64_t tail = __atomic_load_n(&neo_int_tail, __ATOMIC_ACQUIRE);
+	uint64_t seq = neo_int_seq++;
+
+	if(head - tail >= INTRINGL) return; //Full, the gap in seq shows the loss
+
+	neo_gpio_event_t *ev = &neo_int_ring[head % INTRINGL];
+	ev->pin = pin;
+	ev->value = value;
+	ev->timestamp_ns = ts;
+	ev->seq = seq;
+	__atomic_store_n(&neo_int_head, head + 1, __ATOMIC_RELEASE); //Publish the slot
+}
+
+//Turns an edge mode string into it's INTEDGE* code, NEO_FAIL if it isn't one
+int __neo_interrupt_mode(const char *mode) {
+	if(strcmp(mode, RISINGEDGE) == 0) return INTEDGERISING;
+	if(strcmp(mode, FALLINGEDGE) == 0) return INTEDGEFALLING;
+	if(strcmp(mode, BOTHEDGE) == 0) return INTEDGEBOTH;
+	if(strcmp(mode, NOEDGE) == 0) return INTEDGENONE;
+	return NEO_FAIL;
+}
+
+//Turns an INTEDGE* code back into it's edge mode string
+const char *__neo_interrupt_edge_name(int edge) {
+	if(edge == INTEDGERISING) return RISINGEDGE;
+	if(edge == INTEDGEFALLING) return FALLINGEDGE;
+	if(edge == INTEDGEBOTH) return BOTHEDGE;
+	return NOEDGE;
+}
+
+//Hands an edge of a pin to whatever is attached to it
+void __neo_interrupt_dispatch(int pin, int value, uint64_t ts) {
+	interrupt_t *inter = &neo_gpio_interrupts[pin];
+
+	if(!inter->attached) return;
+
+	int counting = __atomic_load_n(&inter->counting, __ATOMIC_RELAXED);
+	if(counting != INTEDGENONE && value != NEO_FAIL) {
+		if(counting == INTEDGEBOTH || counting == ((value) ? INTEDGERISING : INTEDGEFALLING)) {
+			__atomic_add_fetch(&inter->count, 1, __ATOMIC_RELAXED);
+		}
+	}
+
+	__neo_interrupt_push(pin, value, ts);
+	if(__atomic_load_n(&inter->intfunc, __ATOMIC_ACQUIRE) == NULL) return;
+
+	//Hand the call to the callback thread, the dispatcher never waits on user code
+	uint64_t head = __atomic_load_n(&neo_int_call_head, __ATOMIC_RELAXED);
+	if(head - __atomic_load_n(&neo_int_call_tail, __ATOMIC_ACQUIRE) >= INTRINGL) return; //Callbacks are too far behind
+
+	neo_int_calls[head % INTRINGL].pin = pin;
+	neo_int_calls[head % INTRINGL].value = value;
+	__atomic_store_n(&neo_int_call_head, head + 1, __ATOMIC_RELEASE);
+
+	uint64_t one = 1;
+	if(write(neo_int_cbwake, &one, sizeof(one)) < 0) return;
+}
+
+//The callback thread, calls the user functions in the order of the edges
+void *__neo_callback_loop(void *arg) {
+	uint64_t kicks, tail, head;
+	(void) arg;
+
+	while(1) {
+		if(read(neo_int_cbwake, &kicks, sizeof(kicks)) < 0 && errno == EINTR) continue;
+		if(__atomic_load_n(&neo_int_stop, __ATOMIC_ACQUIRE)) return NULL;
+
+		tail = __atomic_load_n(&neo_int_call_tail, __ATOMIC_RELAXED);
+		head = __atomic_load_n(&neo_int_call_head, __ATOMIC_ACQUIRE);
+		for(; tail != head; tail++) {
+			callback_t call = neo_int_calls[tail % INTRINGL];
+			interrupt_t *inter = &neo_gpio_interrupts[call.pin];
+			interruptfunc intfunc = __atomic_load_n(&inter->intfunc, __ATOMIC_ACQUIRE);
+
+			//Call the user function with pinNumber and current flag
+			if(inter->attached && intfunc != NULL) intfunc(inter->pinNum, call.value);
+			__atomic_store_n(&neo_int_call_tail, tail + 1, __ATOMIC_RELEASE);
+		}
+	}
+	return NULL;
+}
+
+//Adds a pulse width to one side of the window
+void __neo_capture_add(uint64_t *widths, int *n, int *next, uint64_t *sum, int size, uint64_t width) {
+	if(*n == size) *sum -= widths[*next]; //Slide out the oldest
+	else (*n)++;
+
+	widths[*next] = width;
+	*sum += width;
+	*next = (*next + 1) % size;
+}
+
+//Measures the pulse that a raw edge just finished
+void __neo_capture_edge(int pin, int value, uint64_t ts) {
+	capture_t *c = &neo_gpio_capture[pin];
+
+	if(__atomic_exchange_n(&c->reset, 0, __ATOMIC_ACQUIRE)) {
+		c->size = __atomic_load_n(&c->window, __ATOMIC_RELAXED);
+		c->level = -1;
+		c->hn = c->ln = c->hi = c->li = 0;
+		c->hsum = c->lsum = 0;
+	}
+	if(c->size <= 0 || value == NEO_FAIL) return;
+
+	//A missed edge shows up as the same level twice, that pulse can't be trusted
+	if(c->level == !value && ts > c->last) {
+		if(value == HIGH) __neo_capture_add(c->low, &c->ln, &c->li, &c->lsum, c->size, ts - c->last);
+		else __neo_capture_add(c->high, &c->hn, &c->hi, &c->hsum, c->size, ts - c->last);
+	}
+	c->level = value;
+	c->last = ts;
+
+	//Publish, odd seq means a write is going on
+	unsigned int seq = __atomic_load_n(&c->seq, __ATOMIC_RELAXED);
+	__atomic_store_n(&c->seq, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	__atomic_store_n(&c->pub_hsum, c->hsum, __ATOMIC_RELAXED);
+	__atomic_store_n(&c->pub_hn, (uint64_t) c->hn, __ATOMIC_RELAXED);
+	__atomic_store_n(&c->pub_lsum, c->lsum, __ATOMIC_RELAXED);
+	__atomic_store_n(&c->pub_ln, (uint64_t) c->ln, __ATOMIC_RELAXED);
+	__atomic_store_n(&c->pub_last, c->last, __ATOMIC_RELAXED);
+	__atomic_store_n(&c->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+//Current CLOCK_MONOTONIC time in nanoseconds, the same clock as the chardev event timestamps
+uint64_t __neo_interrupt_now() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+//Reports the raw level if it's been held long enough and the lock out is over
+void __neo_debounce_check(int pin, uint64_t now) {
+	debounce_t *d = &neo_gpio_debounce[pin];
+	uint64_t glitch = __atomic_load_n(&d->glitch, __ATOMIC_RELAXED);
+
+	d->deadline = 0;
+	if(d->level == d->reported) return; //Bounced back, nothing happened
+
+	if(now < d->last + glitch) { //Too short to be sure yet
+		d->deadline = d->last + glitch;
+		return;
+	}
+	if(now < d->lock) { //Still bouncing from the last transition
+		d->deadline = d->lock;
+		return;
+	}
+
+	d->reported = d->level;
+	d->lock = now + __atomic_load_n(&d->stable, __ATOMIC_RELAXED);
+	if(d->lock > now) d->deadline = d->lock; //See where the pin settled after the window
+	__atomic_add_fetch(&d->reports, 1, __ATOMIC_RELAXED);
+
+	__neo_interrupt_dispatch(pin, d->level, d->last);
+}
+
+//Runs a raw edge through the debounce of the pin
+void __neo_interrupt_edge(int pin, int value, uint64_t ts) {
+	debounce_t *d = &neo_gpio_debounce[pin];
+
+	__neo_capture_edge(pin, value, ts); //Measure before the debounce touches anything
+	__neo_encoder_edge(pin, value, ts);
+	if(value != NEO_FAIL) {
+		__atomic_store_n(&neo_gpio_interrupts[pin].level, value, __ATOMIC_RELEASE);
+		__neo_vcd_record(pin, value, ts);
+	}
+
+	__atomic_add_fetch(&d->edges, 1, __ATOMIC_RELAXED);
+	if(value == NEO_FAIL) { //Can't debounce a failed read, just pass it on
+		__atomic_add_fetch(&d->reports, 1, __ATOMIC_RELAXED);
+		__neo_interrupt_dispatch(pin, value, ts);
+		return;
+	}
+
+	int edge = __atomic_load_n(&neo_gpio_interrupts[pin].edge, __ATOMIC_RELAXED);
+	if(edge == INTEDGERISING || edge == INTEDGEFALLING) {
+		//Only one direction reaches us, every wake up is that edge (the level read after it can be late) so only the lock out applies
+		uint64_t now = __neo_interrupt_now();
+		if(now < d->lock) return;
+		d->level = d->reported = (edge == INTEDGERISING) ? HIGH : LOW;
+		d->last = ts;
+		d->lock = now + __atomic_load_n(&d->stable, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&d->reports, 1, __ATOMIC_RELAXED);
+		__neo_interrupt_dispatch(pin, d->level, ts);
+		return;
+	}
+
+	d->level = value;
+	d->last = ts;
+	__neo_debounce_check(pin, __neo_interrupt_now());
+}
+
+//Arms the timer for the closest debounce deadline
+void __neo_debounce_arm() {
+	struct itimerspec spec;
+	uint64_t next = 0;
+	int pin;
+
+	for(pin = 0; pin < GPIOPORTSL; pin++) {
+		uint64_t d = neo_gpio_debounce[pin].deadline;
+		if(neo_gpio_interrupts[pin].attached && d != 0 && (next == 0 || d < next)) next = d;
+	}
+
+	memset(&spec, 0, sizeof(spec)); //Zero disarms
+	spec.it_value.tv_sec = next / 1000000000ULL;
+	spec.it_value.tv_nsec = next % 1000000000ULL;
+	timerfd_settime(neo_int_timer, TFD_TIMER_ABSTIME, &spec, NULL);
+}
+
+//Checks every pin that has a debounce deadline due
+void __neo_debounce_expire() {
+	uint64_t expired, now = __neo_interrupt_now();
+	int pin;
+
+	if(read(neo_int_timer, &expired, sizeof(expired)) < 0) return; //Clear the timer
+
+	for(pin = 0; pin < GPIOPORTSL; pin++) {
+		uint64_t d = neo_gpio_debounce[pin].deadline;
+		if(neo_gpio_interrupts[pin].attached && d != 0 && d <= now) __neo_debounce_check(pin, now);
+	}
+}
+
+//Reads the current value of a sysfs pin that woke the dispatcher
+void __neo_interrupt_pin(int pin) {
+	char r_buff[buf_r_size]; //Store data buffer
+	uint64_t now = __neo_interrupt_now();
+	int f_data; //Store data from interrupt event
+	int fd = neo_gpio_interrupts[pin].fd;
+
+	//Reading the value also clears the POLLPRI for the next edge
+	lseek(fd, 0, SEEK_SET);
+	ssize_t r = read(fd, r_buff, buf_r_size - 1);
+
+	if(r < 1) f_data = NEO_FAIL; //On data recieve failed
+	else f_data = (r_buff[0] == '1') ? HIGH : LOW;
+
+	__neo_interrupt_edge(pin, f_data, now);
+}
+
+//Hands the first edge since the wait started to a thread in neo_gpio_wait_edge()
+void __neo_interrupt_wake(int pin, uint64_t ts) {
+	interrupt_t *inter = &neo_gpio_interrupts[pin];
+	uint64_t one = 1, none = 0;
+
+	pthread_mutex_lock(&neo_int_wait_lock);
+	if(inter->waitfd >= 0 && ts >= inter->waitstart
+			&& __atomic_compare_exchange_n(&inter->waited, &none, ts, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+		if(write(inter->waitfd, &one, sizeof(one)) != sizeof(one)) inter->waited = 0;
+	}
+	pthread_mutex_unlock(&neo_int_wait_lock);
+}
+
+//Reads the queued line events of a bank request and dispatches them by line
+void __neo_interrupt_bank(int bank) {
+#ifdef GPIO_V2_GET_LINE_IOCTL
+	struct gpio_v2_line_event evs[INTEVENTSL];
+	int fd = -1, pin;
+	ssize_t r, e;
+
+	for(pin = 0; pin < GPIOPORTSL; pin++) {
+		if(GPIOBANK[pin] == bank) {
+			fd = __neo_gpio_edge_fd(pin);
+			break;
+		}
+	}
+	if(fd < 0) return;
+
+	r = read(fd, evs, sizeof(evs));
+	if(r < (ssize_t) sizeof(evs[0])) return;
+
+	for(e = 0; e < r / (ssize_t) sizeof(evs[0]); e++) {
+		int value = (evs[e].id == GPIO_V2_LINE_EVENT_RISING_EDGE) ? HIGH : LOW;
+
+		//More than one port can be on the same line
+		for(pin = 0; pin < GPIOPORTSL; pin++) {
+			if(GPIOBANK[pin] == bank && GPIOLINE[pin] == (int) evs[e].offset) {
+				if(neo_gpio_interrupts[pin].attached) __neo_interrupt_edge(pin, value, evs[e].timestamp_ns);
+				else __neo_interrupt_wake(pin, evs[e].timestamp_ns);
+			}
+		}
+	}
+#else
+	(void) bank;
+#endif
+}
+
+//The dispatcher thread, waits on every attached pin at once
+void *__neo_interrupt_loop(void *arg) {
+	struct epoll_event evs[INTEVENTSL];
+	int n, e;
+	(void) arg;
+
+	while(1) {
+		n = epoll_wait(neo_int_epoll, evs, INTEVENTSL, -1);
+		if(n < 0) {
+			if(errno == EINTR) continue;
+			break;
+		}
+
+		for(e = 0; e < n; e++) {
+			unsigned int id = evs[e].data.u32;
+
+			if(id == INTWAKEID) return NULL; //Asked to stop
+			if(id == INTTIMERID) __neo_debounce_expire();
+			else if(id >= GPIOPORTSL) __neo_interrupt_bank(id - GPIOPORTSL);
+			else __neo_interrupt_pin(id);
+		}
+
+		__neo_debounce_arm();
+	}
+	return NULL;
+}
+
+//Starts the dispatcher thread on the first attached pin (neo_int_lock held)
+int __neo_interrupt_start() {
+	struct epoll_event ev;
+
+	if(neo_int_epoll >= 0) return NEO_OK;
+
+	neo_int_epoll = epoll_create1(EPOLL_CLOEXEC);
+	neo_int_wake = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	neo_int_timer = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+	neo_int_cbwake = eventfd(0, EFD_CLOEXEC);
+	if(neo_int_epoll < 0 || neo_int_wake < 0 || neo_int_timer < 0 || neo_int_cbwake < 0) {
+		__neo_interrupt_stop();
+		return NEO_INTERRUPT_ERROR;
+	}
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.u32 = INTWAKEID;
+	epoll_ctl(neo_int_epoll, EPOLL_CTL_ADD, neo_int_wake, &ev);
+	ev.data.u32 = INTTIMERID;
+	epoll_ctl(neo_int_epoll, EPOLL_CTL_ADD, neo_int_timer, &ev);
+
+	neo_int_stop = 0;
+	if(pthread_create(&neo_int_cbthread, NULL, __neo_callback_loop, NULL) != 0) {
+		__neo_interrupt_stop();
+		return NEO_INTERRUPT_ERROR;
+	}
+	neo_int_threads |= 2;
+
+	if(pthread_create(&neo_int_thread, NULL, __neo_interrupt_loop, NULL) != 0) {
+		__neo_interrupt_stop();
+		return NEO_INTERRUPT_ERROR;
+	}
+	neo_int_threads |= 1;
+	return NEO_OK;
+}
+
+//Adds the line request of a bank to the dispatcher, the whole bank shares it so it's only added once (neo_int_lock held)
+int __neo_interrupt_watch_bank(int bank, int fd) {
+	struct epoll_event ev;
+	int ret = NEO_OK;
+
+	if(neo_int_banks[bank] == 0) {
+		memset(&ev, 0, sizeof(ev));
+		ev.events = EPOLLIN;
+		ev.data.u32 = GPIOPORTSL + bank;
+		if(epoll_ctl(neo_int_epoll, EPOLL_CTL_ADD, fd, &ev) < 0 && errno != EEXIST) ret = NEO_INTERRUPT_ERROR;
+	}
+	if(ret == NEO_OK) neo_int_banks[bank]++;
+	return ret;
+}
+
+//Takes the line request of a bank out of the dispatcher when no pin uses it anymore (neo_int_lock held)
+void __neo_interrupt_unwatch_bank(int bank, int fd) {
+	if(neo_int_banks[bank] > 0 && --neo_int_banks[bank] == 0 && neo_int_epoll >= 0) epoll_ctl(neo_int_epoll, EPOLL_CTL_DEL, fd, NULL);
+}
+
+//Adds the edge file descriptor of a pin to the dispatcher (neo_int_lock held)
+int __neo_interrupt_watch(int pin) {
+	struct epoll_event ev;
+	char r_buff[buf_r_size];
+	int fd = __neo_gpio_edge_fd(pin);
+
+	if(fd < 0) return NEO_INTERRUPT_ERROR;
+	neo_gpio_interrupts[pin].fd = fd;
+
+	//Start the debounce from the current level
+	debounce_t *d = &neo_gpio_debounce[pin];
+	d->level = d->reported = __neo_gpio_get_value(pin);
+	d->last = d->lock = d->deadline = 0;
+	__atomic_store_n(&neo_gpio_interrupts[pin].level, d->level, __ATOMIC_RELEASE);
+
+	if(neo_gpio_backend == NEO_GPIO_CHARDEV) return __neo_interrupt_watch_bank(GPIOBANK[pin], fd);
+
+	//Read the value once so the first wait doesn't fire right away
+	lseek(fd, 0, SEEK_SET);
+	if(read(fd, r_buff, buf_r_size - 1) < 0) return NEO_INTERRUPT_ERROR;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLPRI | EPOLLERR;
+	ev.data.u32 = pin;
+	if(epoll_ctl(neo_int_epoll, EPOLL_CTL_ADD, fd, &ev) < 0 && errno != EEXIST) return NEO_INTERRUPT_ERROR;
+	return NEO_OK;
+}
+
+//Takes the edge file descriptor of a pin out of the dispatcher (neo_int_lock held)
+void __neo_interrupt_unwatch(int pin) {
+	int fd = neo_gpio_interrupts[pin].fd;
+
+	if(fd < 0 || neo_int_epoll < 0) return;
+	if(neo_gpio_backend == NEO_GPIO_CHARDEV) __neo_interrupt_unwatch_bank(GPIOBANK[pin], fd); //Other pins of the bank might still be using the request
+	else epoll_ctl(neo_int_epoll, EPOLL_CTL_DEL, fd, NULL);
+}
+
+//Gets the level the dispatcher last saw on a cached pin, NEO_FAIL if the pin isn't cached
+int __neo_interrupt_cached(int pin) {
+	if(!__atomic_load_n(&neo_gpio_interrupts[pin].cached, __ATOMIC_ACQUIRE)) return NEO_FAIL;
+	return __atomic_load_n(&neo_gpio_interrupts[pin].level, __ATOMIC_ACQUIRE);
+}
+
+//This will make sure all the interrupts have presets and don't crash after free
+void __neo_initialize_interrupts() {
+	int ind;
+
+	__neo_interrupt_free(); //Stop the dispatcher if the gpio gets initialized again
+	//Loop through each struct set default params
+	for(ind = 0; ind < GPIOPORTSL; ind++) {
+		interrupt_t *t_temp = &neo_gpio_interrupts[ind];
+		
+		//Set the default values and functions
+		t_temp->pinNum = ind;
+		t_temp->attached = 0;
+		t_temp->cached = 0;
+		t_temp->edge = INTEDGENONE;
+		t_temp->counting = INTEDGENONE;
+		t_temp->count = 0;
+		t_temp->waiting = 0;
+		t_temp->waitfd = -1;
+		t_temp->fd = -1;
+		__atomic_store_n(&t_temp->intfunc, &__neo_dummy_int_event, __ATOMIC_RELEASE);
+	}
+
+	for(ind = 0; ind < GPIOBANKL; ind++) neo_int_banks[ind] = 0;
+}
+
+//Stops the dispatcher thread and detaches every pin (neo_int_lock held, it's let go while the callbacks finish)
+void __neo_interrupt_stop() {
+	int ind, threads = neo_int_threads;
+
+	uint64_t one = 1;
+
+	//Stop the dispatcher first so nothing new gets queued for the callbacks
+	neo_int_threads = 0;
+	if((threads & 1) && write(neo_int_wake, &one, sizeof(one)) == sizeof(one)) pthread_join(neo_int_thread, NULL);
+	if(threads & 2) {
+		//A callback might be attaching or detaching, so it can't be waited on with the lock
+		__atomic_store_n(&neo_int_stop, 1, __ATOMIC_RELEASE);
+		if(write(neo_int_cbwake, &one, sizeof(one)) == sizeof(one)) {
+			pthread_mutex_unlock(&neo_int_lock);
+			pthread_join(neo_int_cbthread, NULL);
+			pthread_mutex_lock(&neo_int_lock);
+		}
+	}
+	__neo_encoder_free_all(); //Their pins are detached below
+
+	//Nothing will hand the waiters an edge anymore, wake them up empty handed
+	pthread_mutex_lock(&neo_int_wait_lock);
+	for(ind = 0; ind < GPIOPORTSL; ind++) {
+		if(neo_gpio_interrupts[ind].waitfd < 0) continue;
+		if(write(neo_gpio_interrupts[ind].waitfd, &one, sizeof(one)) != sizeof(one)) continue; //It times out on it's own then
+	}
+	pthread_mutex_unlock(&neo_int_wait_lock);
+
+	if(neo_int_wake >= 0) close(neo_int_wake);
+	if(neo_int_timer >= 0) close(neo_int_timer);
+	if(neo_int_cbwake >= 0) close(neo_int_cbwake);
+	if(neo_int_epoll >= 0) close(neo_int_epoll);
+	neo_int_wake = neo_int_timer = neo_int_cbwake = neo_int_epoll = -1;
+
+	for(ind = 0; ind < GPIOPORTSL; ind++) {
+		__atomic_store_n(&neo_gpio_interrupts[ind].cached, 0, __ATOMIC_RELEASE); //Reads go back to the kernel
+		__atomic_store_n(&neo_gpio_interrupts[ind].counting, INTEDGENONE, __ATOMIC_RELAXED);
+		neo_gpio_interrupts[ind].attached = 0;
+	}
+	for(ind = 0; ind < GPIOBANKL; ind++) neo_int_banks[ind] = 0;
+	neo_int_runs++;
+
+	//Nothing can produce anymore, so throw away the old edges
+	neo_int_head = neo_int_tail = neo_int_seq = 0;
+	neo_int_call_head = neo_int_call_tail = 0;
+}
+
+//Stops the dispatcher thread and detaches every pin (called by neo_gpio_free)
+void __neo_interrupt_free() {
+	pthread_mutex_lock(&neo_int_lock);
+	__neo_interrupt_stop();
+	pthread_mutex_unlock(&neo_int_lock);
+}
+
+//Sets the edge the kernel reports for a pin and turns off what the new edge can't serve anymore
+void __neo_interrupt_set_edge(int pin, int edge) {
+	interrupt_t *inter = &neo_gpio_interrupts[pin];
+	int counting = __atomic_load_n(&inter->counting, __ATOMIC_RELAXED);
+
+	__atomic_store_n(&inter->edge, edge, __ATOMIC_RELAXED);
+	if(edge == INTEDGEBOTH) return;
+
+	//The cache and the capture need every edge, one direction leaves the level stale and the pulses unmeasured
+	__atomic_store_n(&inter->cached, 0, __ATOMIC_RELEASE);
+	if(__atomic_load_n(&neo_gpio_capture[pin].window, __ATOMIC_RELAXED) > 0) {
+		__atomic_store_n(&neo_gpio_capture[pin].window, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&neo_gpio_capture[pin].reset, 1, __ATOMIC_RELEASE);
+	}
+
+	//A counter of edges that aren't reported anymore would silently stop
+	if(counting != INTEDGENONE && counting != edge) __atomic_store_n(&inter->counting, INTEDGENONE, __ATOMIC_RELEASE);
+}
+
+//Polls one file descriptor until the deadline, NEO_OK when it's ready
+int __neo_interrupt_poll(int fd, short events, int64_t timeout_ns, uint64_t deadline) {
+	struct pollfd pfd;
+	struct timespec left;
+	uint64_t now;
+	int ret;
+
+	pfd.fd = fd;
+	pfd.events = events;
+
+	while(1) {
+		now = __neo_interrupt_now();
+		if(timeout_ns >= 0 && now >= deadline) return NEO_TIMEOUT_ERROR;
+
+		left.tv_sec = (deadline - now) / 1000000000ULL;
+		left.tv_nsec = (deadline - now) % 1000000000ULL;
+
+		pfd.revents = 0;
+		ret = ppoll(&pfd, 1, (timeout_ns >= 0) ? &left : NULL, NULL);
+		if(ret < 0 && errno == EINTR) continue;
+		if(ret < 0) return NEO_INTERRUPT_ERROR;
+		return (ret == 0) ? NEO_TIMEOUT_ERROR : NEO_OK;
+	}
+}
+
+//Waits for the edge on the value file of the pin (sysfs and mmap)
+int __neo_interrupt_wait_value(int pin, int64_t timeout_ns, uint64_t *ts) {
+	char r_buff[buf_r_size];
+	uint64_t now;
+	int ret, fd = __neo_gpio_edge_fd(pin);
+
+	if(fd < 0) return NEO_INTERRUPT_ERROR;
+
+	lseek(fd, 0, SEEK_SET); //Read the value so only a new edge wakes us
+	if(read(fd, r_buff, buf_r_size - 1) < 0) return NEO_INTERRUPT_ERROR;
+
+	ret = __neo_interrupt_poll(fd, POLLPRI | POLLERR, timeout_ns, __neo_interrupt_now() + (uint64_t) timeout_ns);
+	if(ret != NEO_OK) return ret;
+
+	now = __neo_interrupt_now();
+	lseek(fd, 0, SEEK_SET); //Clear the edge
+	if(read(fd, r_buff, buf_r_size - 1) < 0) return NEO_INTERRUPT_ERROR;
+	if(ts != NULL) *ts = now;
+	return NEO_OK;
+}
+
+//Waits for the edge through the dispatcher, it's the only reader of the bank request so the other lines keep their events
+int __neo_interrupt_wait_bank(int pin, int64_t timeout_ns, uint64_t *ts) {
+	interrupt_t *inter = &neo_gpio_interrupts[pin];
+	uint64_t kicks, start;
+	unsigned int run;
+	int ret, fd, bank = GPIOBANK[pin], req = __neo_gpio_edge_fd(pin);
+
+	if(req < 0) return NEO_INTERRUPT_ERROR;
+	fd = eventfd(0, EFD_CLOEXEC);
+	if(fd < 0) return NEO_INTERRUPT_ERROR;
+
+	start = __neo_interrupt_now();
+	pthread_mutex_lock(&neo_int_lock);
+	ret = __neo_interrupt_start();
+	if(ret == NEO_OK) {
+		pthread_mutex_lock(&neo_int_wait_lock);
+		inter->waitstart = start;
+		inter->waited = 0;
+		inter->waitfd = fd;
+		pthread_mutex_unlock(&neo_int_wait_lock);
+		ret = __neo_interrupt_watch_bank(bank, req);
+	}
+	run = neo_int_runs;
+	pthread_mutex_unlock(&neo_int_lock);
+
+	if(ret == NEO_OK) {
+		ret = __neo_interrupt_poll(fd, POLLIN, timeout_ns, start + (uint64_t) timeout_ns);
+		pthread_mutex_lock(&neo_int_lock);
+		if(run == neo_int_runs) __neo_interrupt_unwatch_bank(bank, req); //A stop already let go of it
+		pthread_mutex_unlock(&neo_int_lock);
+	}
+
+	pthread_mutex_lock(&neo_int_wait_lock);
+	inter->waitfd = -1;
+	pthread_mutex_unlock(&neo_int_wait_lock);
+
+	if(ret == NEO_OK && read(fd, &kicks, sizeof(kicks)) != sizeof(kicks)) ret = NEO_INTERRUPT_ERROR;
+	if(ret == NEO_OK && inter->waited == 0) ret = NEO_INTERRUPT_ERROR; //Woken up by neo_gpio_free()
+	if(ret == NEO_OK && ts != NULL) *ts = inter->waited;
+	close(fd);
+	return ret;
+}
+
+//Attaches an interrupt to a pin (neo_int_lock held) @see neo_gpio_attach_interrupt()
+int __neo_interrupt_attach(int pin, const char *mode, interruptfunc intfunc) {
+	interrupt_t *inter = &neo_gpio_interrupts[pin];
+	int ret;
+
+	if(inter->waiting) return NEO_INTERRUPT_ERROR; //neo_gpio_wait_edge() puts it's old edge back
+
+	//If the pin is output, set the pin to input and setup the edge
+	if(GPIOGET(DIRGPIO, pin) == (unsigned char) OUTPUT) { 
+		ret = neo_gpio_pin_mode(pin, INPUT);
+		
+		if(ret != NEO_OK) return ret;
+	}
+	
+	ret = __neo_gpio_set_edge(pin, mode);
+	if(ret != NEO_OK) return ret;
+
+	__neo_interrupt_set_edge(pin, __neo_interrupt_mode(mode));
+	inter->pinNum = pin;
+	__atomic_store_n(&inter->intfunc, intfunc, __ATOMIC_RELEASE);
+
+	if(inter->attached) return NEO_OK; //Already watched by the dispatcher
+
+	ret = __neo_interrupt_start();
+	if(ret != NEO_OK) return ret;
+
+	inter->attached = 1;
+	ret = __neo_interrupt_watch(pin);
+	if(ret != NEO_OK) inter->attached = 0;
+	
+	return ret;
+}
+
+//Detaches the interrupt of a pin (neo_int_lock held) @see neo_gpio_detach_interrupt()
+int __neo_interrupt_detach(int pin) {
+	interrupt_t *inter = &neo_gpio_interrupts[pin];
+
+	if(!inter->attached) return NEO_INTERRUPT_ERROR;
+
+	__atomic_store_n(&inter->cached, 0, __ATOMIC_RELEASE); //Nothing keeps the level up to date anymore
+	inter->attached = 0; //Stop dispatching first, queued bank events are skipped after this
+	__neo_interrupt_unwatch(pin);
+	neo_gpio_debounce[pin].deadline = 0;
+	__atomic_store_n(&inter->intfunc, &__neo_dummy_int_event, __ATOMIC_RELEASE);
+	__atomic_store_n(&inter->edge, INTEDGENONE, __ATOMIC_RELAXED);
+
+	return __neo_gpio_set_edge(pin, NOEDGE);
+}
+
+#endif
+
+/**
+ * @brief Attaches an interrupt to a pin
+ * 
+ * This will watch the pin for a change of state based on what you want
+ * A state of either "rising" to only detect when the pin changes from 0 to 1. "falling" for the
+ * function to only call from 1 to 0 and "both" that happens if it changes either way.
+ * All the attached pins share one dispatcher thread, that's started on the first attach.
+ * 
+ * @return NEO_OK/NEO_INTERRUPT_ERROR/NEO_PIN_ERROR/NEO_UNUSABLE_ERRROR if the interrupt failed
+ * @param pin The pin to attach the interrupt to
+ * @param mode The mode to put the pin in available ("both", "rising", "falling")
+ * @param intfunc The function pointer to the interrupt return (NULL to only queue the edges @see neo_gpio_poll_events())
+ *
+ * @note Attaching the same pin again just replaces the mode and the function in place @see neo_gpio_detach_interrupt()
+ * @note Like neo_gpio_set_interrupt_mode() anything but "both" turns off the cache, the capture and a counter of the other edges
+ */
+int neo_gpio_attach_interrupt(int pin, const char * mode, interruptfunc intfunc) {
+	int ret;
+
+	//Safety check to see if both arguments are valid
+	if(strcmp(mode, BOTHEDGE) != 0 && strcmp(mode, RISINGEDGE) != 0 
+				&& strcmp(mode, FALLINGEDGE) != 0) return NEO_INTERRUPT_ERROR;
+	if(pin < 0 || pin >= GPIOPORTSL) return NEO_PIN_ERROR;
+	if(__neo_gpio_ready(pin) != NEO_OK) return NEO_UNUSABLE_ERROR;
+
+	pthread_mutex_lock(&neo_int_lock);
+	ret = __neo_interrupt_attach(pin, mode, intfunc);
+	pthread_mutex_unlock(&neo_int_lock);
+	return ret;
+}
+
+/**
+ * @brief Changes the edge an attached interrupt listens for
+ * 
+ * Only the edge of the pin is rewritten, the dispatcher keeps watching it and the callback stays the same
+ * 
+ * @return NEO_OK/NEO_INTERRUPT_ERROR/NEO_PIN_ERROR if the pin isn't attached or the mode is wrong
+ * @param pin The attached pin
+ * @param mode The new mode available ("both", "rising", "falling")
+ *
+ * @note Anything but "both" turns off the cache (the level could go stale), the capture (it measures both edges)
+ * and a counter of the edges that stop being reported @see neo_gpio_set_cached() neo_gpio_set_capture() neo_gpio_set_counter()
+ */
+int neo_gpio_set_interrupt_mode(int pin, const char * mode) {
+	if(strcmp(mode, BOTHEDGE) != 0 && strcmp(mode, RISINGEDGE) != 0 
+				&& strcmp(mode, FALLINGEDGE) != 0) return NEO_INTERRUPT_ERROR;
+	if(pin < 0 || pin >= GPIOPORTSL) return NEO_PIN_ERROR;
+
+	pthread_mutex_lock(&neo_int_lock);
+	int ret = NEO_INTERRUPT_ERROR;
+	if(neo_gpio_interrupts[pin].attached) {
+		if(strcmp(mode, BOTHEDGE) != 0) __atomic_store_n(&neo_gpio_interrupts[pin].cached, 0, __ATOMIC_RELEASE);
+
+		ret = __neo_gpio_set_edge(pin, mode);
+		if(ret == NEO_OK) __neo_interrupt_set_edge(pin, __neo_interrupt_mode(mode));
+	}
+	pthread_mutex_unlock(&neo_int_lock);
+	return ret;
+}
+
+/**
+ * @brief Detaches the interrupt of a pin
+ * 
+ * The pin is taken out of the dispatcher and it's edge is turned off, the callback won't be
+ * called again and no more edges are queued for it. The dispatcher thread keeps running for the other pins
+ * 
+ * @return NEO_OK/NEO_PIN_ERROR or NEO_INTERRUPT_ERROR if the pin wasn't attached
+ * @param pin The pin to detach
+ *
+ * @note The pin stays an input, attach it again at any time
+ */
+int neo_gpio_detach_interrupt(int pin) {
+	int ret;
+
+	if(pin < 0 || pin >= GPIOPORTSL) return NEO_PIN_ERROR;
+
+	pthread_mutex_lock(&neo_int_lock);
+	ret = __neo_interrupt_detach(pin);
+	pthread_mutex_unlock(&neo_int_lock);
+	return ret;
+}
+
+/**
+ * @brief Drains the queued edges of the attached pins
+ * 
+ * Every edge seen by the interrupt dispatcher is queued with the pin, the new state, a
+ * CLOCK_MONOTONIC timestamp (the kernel's on the character device backend) and a sequence number.
+ * This copies up to n of the oldest ones in order and removes them from the queue, it never blocks.
+ * 
+ * @return The amount of events copied (0 if none are queued) or NEO_FAIL on invalid arguments
+ * @param buf The array to copy the events into
+ * @param n The size of the array
+ *
+ * @note Only 1024 edges are kept, when more are missed a jump in the seq of the next event shows how many
+ * @warning Only call this from one thread at a time
+ */
+int neo_gpio_poll_events(neo_gpio_event_t *buf, int n) {
+	uint64_t tail, head, ind, count;
+
+	if(buf == NULL || n < 0) return NEO_FAIL;
+
+	tail = __atomic_load_n(&neo_int_tail, __ATOMIC_RELAXED);
+	head = __atomic_load_n(&neo_int_head, __ATOMIC_ACQUIRE); //Makes the published slots visible
+
+	count = head - tail;
+	if(count > (uint64_t) n) count = n;
+
+	for(ind = 0; ind < count; ind++) buf[ind] = neo_int_ring[(tail + ind) % INTRINGL];
+	__atomic_store_n(&neo_int_tail, tail + count, __ATOMIC_RELEASE); //Give the slots back
+
+	return (int) count;
+}
+
+/**
+ * @brief Waits for an edge on a pin
+ * 
+ * Blocks the calling thread until the pin changes the way you want or the time runs out, without
+ * a callback. On sysfs (and mmap) this polls the value file directly so it's the lowest latency way to catch
+ * a single edge. On the character device backend the bank line request is shared by every line of the bank,
+ * so the edge is handed over by the dispatcher thread (it's started if it isn't running) and the events of the
+ * other lines still reach their own interrupts and waiters
+ * 
+ * @return NEO_OK on the edge, NEO_TIMEOUT_ERROR if the time ran out or NEO_PIN_ERROR/NEO_UNUSABLE_ERROR/NEO_INTERRUPT_ERROR
+ * @param pin The pin to wait on
+ * @param mode The edge to wait for ("both", "rising", "falling")
+ * @param timeout_ns How long to wait in nanoseconds (negative waits forever)
+ * @param ts Where to store the CLOCK_MONOTONIC time of the edge in nanoseconds (can be NULL)
+ *
+ * @note The pin is set to input if it was an output, the edge it had before is put back on every return
+ * @warning This fails with NEO_INTERRUPT_ERROR on pins that are attached to an interrupt or already waited on by another thread,
+ * and attaching the pin fails while it's waited on
+ */
+int neo_gpio_wait_edge(int pin, const char * mode, int64_t timeout_ns, uint64_t *ts) {
+	interrupt_t *inter;
+	int ret, prev, idle = 0;
+
+	if(strcmp(mode, BOTHEDGE) != 0 && strcmp(mode, RISINGEDGE) != 0 
+				&& strcmp(mode, FALLINGEDGE) != 0) return NEO_INTERRUPT_ERROR;
+	if(pin < 0 || pin >= GPIOPORTSL) return NEO_PIN_ERROR;
+	if(__neo_gpio_ready(pin) != NEO_OK) return NEO_UNUSABLE_ERROR;
+
+	//The dispatcher owns the edge of attached pins, and only one thread can wait on a pin
+	inter = &neo_gpio_interrupts[pin];
+	pthread_mutex_lock(&neo_int_lock);
+	ret = (!inter->attached && __atomic_compare_exchange_n(&inter->waiting, &idle, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) ? NEO_OK : NEO_INTERRUPT_ERROR;
+	pthread_mutex_unlock(&neo_int_lock);
+	if(ret != NEO_OK) return ret;
+	prev = __atomic_load_n(&inter->edge, __ATOMIC_RELAXED);
+
+	if(GPIOGET(DIRGPIO, pin) == (unsigned char) OUTPUT) ret = neo_gpio_pin_mode(pin, INPUT);
+	if(ret == NEO_OK) ret = __neo_gpio_set_edge(pin, mode);
+	if(ret == NEO_OK) {
+		if(neo_gpio_backend == NEO_GPIO_CHARDEV) ret = __neo_interrupt_wait_bank(pin, timeout_ns, ts);
+		else ret = __neo_interrupt_wait_value(pin, timeout_ns, ts);
+
+		//Put the edge back the way it was, on a timeout or an error too
+		__neo_gpio_set_edge(pin, __neo_interrupt_edge_name(prev));
+	}
+
+	__atomic_store_n(&inter->waiting, 0, __ATOMIC_RELEASE);
+	return ret;
+}
+
+/**
+ * @brief Debounces the interrupt of a pin
+ * 
+ * Bouncing contacts make a burst of edges on every press, the dispatcher filters them so
+ * only validated transitions reach the callback and neo_gpio_poll_events().
+ * A new level has to be held for glitch_ns before it's believed (shorter pulses are dropped),
+ * and after a transition is reported no other one is for stable_ns. When that window ends
+ * the pin is looked at again, so the final level is never lost.
+ * Both at 0 (the default) passes every edge through as it is.
+ * 
+ * @return NEO_OK or NEO_PIN_ERROR if the pin is out of range
+ * @param pin The pin to debounce
+ * @param stable_ns The lock out after a reported transition in nanoseconds
+ * @param glitch_ns The minimum width of a pulse in nanoseconds
+ *
+ * @note Transitions waiting on glitch_ns are reported late, but with the time of their edge
+ */
+int neo_gpio_set_debounce(int pin, uint64_t stable_ns, uint64_t glitch_ns) {
+	if(pin < 0 || pin >= GPIOPORTSL) return NEO_PIN_ERROR;
+
+	__atomic_store_n(&neo_gpio_debounce[pin].stable, stable_ns, __ATOMIC_RELAXED);
+	__atomic_store_n(&neo_gpio_debounce[pin].glitch, glitch_ns, __ATOMIC_RELAXED);
+	return NEO_OK;
+}
+
+/**
+ * @brief Gets how many edges the debounce of a pin threw away
+ * 
+ * Counts every raw edge seen on the pin that didn't turn into a reported transition, use it to
+ * tune the windows of neo_gpio_set_debounce()
+ * 
+ * @return NEO_OK or NEO_PIN_ERROR/NEO_FAIL if the pin is out of range or count is NULL
+ * @param pin The pin to get the counter of
+ * @param count Where to store the amount of suppressed edges
+ */
+int neo_gpio_debounce_suppressed(int pin, uint64_t *count) {
+	if(pin < 0 || pin >= GPIOPORTSL) return NEO_PIN_ERROR;
+	if(count == NULL) return NEO_FAIL;
+
+	//Reports never pass edges, read them first so the difference can't go negative
+	uint64_t reports = __atomic_load_n(&neo_gpio_debounce[pin].reports, __ATOMIC_ACQUIRE);
+	*count = __atomic_load_n(&neo_gpio_debounce[pin].edges, __ATOMIC_ACQUIRE) - reports;
+	return NEO_OK;
+}
+
+/**
+ * @brief Turns the pulse capture of a pin on or off
+ * 
+ * The widths of the high and low pulses of the pin are measured from the timestamps of it's raw edges
+ * (before any debounce) in the dispatcher, so slow callbacks can't distort them. The averages over
+ * the last window pulses of each level are kept up to date on every edge @see neo_gpio_capture_stats()
+ * The pin is attached to the interrupt if it wasn't (without a callback) and set to listen to both edges
+ * 
+ * @return NEO_OK/NEO_PIN_ERROR/NEO_INTERRUPT_ERROR or NEO_PERIOD_ERROR if the window is out of range
+ * @param pin The pin to capture
+ * @param window The amount of pulses to average (1 - 64), 0 to turn the capture off
+ *
+ * @note Turning it off keeps the pin attached @see neo_gpio_detach_interrupt()
+ */
+int neo_gpio_set_capture(int pin, int window) {
+	int ret;
+
+	if(pin < 0 || pin >= GPIOPORTSL) return NEO_PIN_ERROR;
+	if(window < 0 || window > CAPTUREL) return NEO_PERIOD_ERROR;
+
+	if(window > 0) {
+		if(neo_gpio_interrupts[pin].attached) ret = neo_gpio_set_interrupt_mode(pin, BOTHEDGE);
+		else ret = neo_gpio_attach_interrupt(pin, BOTHEDGE, NULL);
+		if(ret != NEO_OK) return ret;
+	}
+
+	//The dispatcher picks the new window up on the next edge
+	__atomic_store_n(&neo_gpio_capture[pin].window, window, __ATOMIC_RELAXED);
+	__atomic_store_n(&neo_gpio_capture[pin].reset, 1, __ATOMIC_RELEASE);
+	return NEO_OK;
+}
+
+/**
+ * @brief Gets the frequency and pulse widths measured on a pin
+ * 
+ * Reads the averages the dispatcher keeps over the capture window @see neo_gpio_set_capture()
+ * It never blocks and doesn't make a syscall besides reading the clock. 
+ * 
+ * @return NEO_OK, NEO_READ_ERROR if no full period was measured yet or NEO_PIN_ERROR/NEO_INTERRUPT_ERROR if it isn't capturing
+ * @param pin The captured pin
+ * @param freq_hz Where to store the frequency in Hertz, 0 when the signal stopped for more than two periods (can be NULL)
+ * @param high_ns Where to store the average high pulse in nanoseconds (can be NULL)
+ * @param low_ns Where to store the average low pulse in nanoseconds (can be NULL)
+ */
+int neo_gpio_capture_stats(int pin, double *freq_hz, uint64_t *high_ns, uint64_t *low_ns) {
+	uint64_t hsum, hn, lsum, ln, last, high, low, now;
+	unsigned int seq;
+	capture_t *c;
+
+	if(pin < 0 || pin >= GPIOPORTSL) return NEO_PIN_ERROR;
+	c = &neo_gpio_capture[pin];
+	if(__atomic_load_n(&c->window, __ATOMIC_RELAXED) <= 0) return NEO_INTERRUPT_ERROR;
+	if(__atomic_load_n(&c->reset, __ATOMIC_ACQUIRE)) return NEO_READ_ERROR; //Not a single edge in the new window
+
+	do { //Retry until the copy didn't overlap a publish
+		seq = __atomic_load_n(&c->seq, __ATOMIC_ACQUIRE);
+		hsum = __atomic_load_n(&c->pub_hsum, __ATOMIC_RELAXED);
+		hn = __atomic_load_n(&c->pub_hn, __ATOMIC_RELAXED);
+		lsum = __atomic_load_n(&c->pub_lsum, __ATOMIC_RELAXED);
+		ln = __atomic_load_n(&c->pub_ln, __ATOMIC_RELAXED);
+		last = __atomic_load_n(&c->pub_last, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	} while((seq & 1) || seq != __atomic_load_n(&c->seq, __ATOMIC_RELAXED));
+
+	if(hn == 0 || ln == 0) return NEO_READ_ERROR;
+
+	high = hsum / hn;
+	low = lsum / ln;
+	now = __neo_interrupt_now();
+
+	if(high_ns != NULL) *high_ns = high;
+	if(low_ns != NULL) *low_ns = low;
+	if(freq_hz != NULL) {
+		if(high + low == 0 || (now > last && now - last > 2 * (high + low))) *freq_hz = 0.0; //Signal stopped
+		else *freq_hz = 1000000000.0 / (double) (high + low);
+	}
+	return NEO_OK;
+}
+
+/**
+ * @brief Turns the cached reads of a pin on or off
+ * 
+ * A cached pin is read from the level the interrupt dispatcher saw on it's last edge, so
+ * neo_gpio_digital_read() answers with an atomic load and doesn't make a syscall.
+ * The pin is attached to the interrupt if it wasn't (without a callback) and set to listen to both edges,
+ * the level is the raw one (before any debounce) just like a read from the kernel
+ * 
+ * @return NEO_OK/NEO_PIN_ERROR/NEO_UNUSABLE_ERROR or NEO_INTERRUPT_ERROR if the pin can't be attached
+ * @param pin The pin to cache
+ * @param enable 1 to read the pin from the cache, 0 to read it from the kernel again
+ *
+ * @note Turning it off keeps the pin attached @see neo_gpio_detach_interrupt()
+ * @warning The level is only as fresh as the dispatcher, right after an edge a read can still get the old level
+ */
+int neo_gpio_set_cached(int pin, int enable) {
+	int ret;
+
+	if(pin < 0 || pin >= GPIOPORTSL) return NEO_PIN_ERROR;
+
+	if(enable) {
+		if(neo_gpio_interrupts[pin].attached) ret = neo_gpio_set_interrupt_mode(pin, BOTHEDGE);
+		else ret = neo_gpio_attach_interrupt(pin, BOTHEDGE, NULL);
+		if(ret != NEO_OK) return ret;
+	}
+
+	//The level was read when the pin was attached and follows every edge since
+	__atomic_store_n(&neo_gpio_interrupts[pin].cached, (enable) ? 1 : 0, __ATOMIC_RELEASE);
+	return NEO_OK;
+}
+
+/**
+ * @brief Turns the edge counter of a pin on or off
+ * 
+ * Every edge the dispatcher reports on the pin (after any debounce) that matches the mode
+ * is counted with a single atomic add, without a callback @see neo_gpio_count_read_and_reset()
+ * The pin is attached to the interrupt if it wasn't (without a callback) with the same mode,
+ * if it was attached to another edge it's set to listen to both edges
+ * 
+ * @return NEO_OK/NEO_PIN_ERROR/NEO_UNUSABLE_ERROR or NEO_INTERRUPT_ERROR if the mode is wrong or the pin can't be attached
+ * @param pin The pin to count
+ * @param mode The edges to count ("both", "rising", "falling") or "none"/NULL to stop counting
+ *
+ * @note The counter starts at 0, turning it off keeps the pin attached @see neo_gpio_detach_interrupt()
+ */
+int neo_gpio_set_counter(int pin, const char * mode) {
+	interrupt_t *inter;
+	int code, edge, ret = NEO_OK;
+
+	if(pin < 0 || pin >= GPIOPORTSL) return NEO_PIN_ERROR;
+	code = (mode == NULL) ? INTEDGENONE : __neo_interrupt_mode(mode);
+	if(code == NEO_FAIL) return NEO_INTERRUPT_ERROR;
+
+	inter = &neo_gpio_interrupts[pin];
+	if(code != INTEDGENONE) {
+		edge = __atomic_load_n(&inter->edge, __ATOMIC_RELAXED);
+
+		if(!inter->attached) ret = neo_gpio_attach_interrupt(pin, mode, NULL);
+		else if(edge != code && edge != INTEDGEBOTH) ret = neo_gpio_set_interrupt_mode(pin, BOTHEDGE);
+		if(ret != NEO_OK) return ret;
+	}
+
+	__atomic_store_n(&inter->counting, INTEDGENONE, __ATOMIC_RELAXED);
+	__atomic_store_n(&inter->count, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&inter->counting, code, __ATOMIC_RELEASE);
+	return NEO_OK;
+}
+
+/**
+ * @brief Reads the edge counter of a pin and sets it back to 0
+ * 
+ * The read and the reset are one atomic exchange, so no edge is lost or counted twice
+ * between two reads. It never blocks and doesn't make a syscall @see neo_gpio_set_counter()
+ * 
+ * @return NEO_OK or NEO_PIN_ERROR/NEO_FAIL if the pin is out of range or count is NULL
+ * @param pin The counted pin
+ * @param count Where to store the amount of edges since the last read
+ */
+int neo_gpio_count_read_and_reset(int pin, uint64_t *count) {
+	if(pin < 0 || pin >= GPIOPORTSL) return NEO_PIN_ERROR;
+	if(count == NULL) return NEO_FAIL;
+
+	*count = __atomic_exchange_n(&neo_gpio_interrupts[pin].count, 0, __ATOMIC_RELAXED);
+	return NEO_OK;
+}
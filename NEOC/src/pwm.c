@@ -30,6 +30,14 @@
  * A threaded pwm manager on ANY gpio pin available on the board as well as
  * A real PWM access to the available pwm pins. Please use device tree editor 
  * to view what pwm pins are available
+ *
+ * Every fake pwm channel is run by one scheduler thread, it keeps the channels in a min-heap
+ * ordered by their next toggle and sleeps to that absolute CLOCK_MONOTONIC deadline.
+ * The thread learns how late the kernel wakes it up and goes to sleep that much earlier,
+ * how well each channel keeps up is measured on the way @see neo_fake_pwm_stats()
+ * 
+ * Channels can be grouped on one period with fixed phases between them @see neo_fake_pwm_group()
+ * every period of a grouped channel starts on the grid of the group so they stay locked
  */
 
 #include <neo.h>
@@ -40,8 +48,12 @@
 #include <string.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <pthread.h>
 #include <time.h>
+#include <errno.h>
+#include <sched.h>
+#include <stdint.h>
 
 //All the pin numbers for the pwm pins and the flags for if they're usable
 unsigned char PWMPORTS[] = {1, 2, 3, 4, 5, 6};
@@ -52,34 +64,81 @@ unsigned char USABLEPWM[] = {0, 0, 0, 0, 0, 0, 0};
 //Size safety of 2 for each for the loops
 int FAKEPWMLIST[MAXFAKEPWM + 2][2];
 
-//FILE pointers to sysfs P = period D = duty and E = enable/disable
-FILE* pwmP[PWMPORTSL + 2];
-FILE* pwmD[PWMPORTSL + 2];
-FILE* pwmE[PWMPORTSL + 2];
+//Raw sysfs file descriptors P = period D = duty and E = enable/disable
+int pwmP[PWMPORTSL + 2] = { [0 ... PWMPORTSL + 1] = -1 };
+int pwmD[PWMPORTSL + 2] = { [0 ... PWMPORTSL + 1] = -1 };
+int pwmE[PWMPORTSL + 2] = { [0 ... PWMPORTSL + 1] = -1 };
+int pwmO[PWMPORTSL + 2] = { [0 ... PWMPORTSL + 1] = -1 }; //Polarity, -1 when the kernel doesn't offer it
+
+//The last values written to each file (-1 is unknown) so only the changes get written
+long long neo_pwm_last_period[PWMPORTSL + 2] = { [0 ... PWMPORTSL + 1] = -1 };
+long long neo_pwm_last_duty[PWMPORTSL + 2] = { [0 ... PWMPORTSL + 1] = -1 };
+long long neo_pwm_last_enable[PWMPORTSL + 2] = { [0 ... PWMPORTSL + 1] = -1 };
+long long neo_pwm_last_polarity[PWMPORTSL + 2] = { [0 ... PWMPORTSL + 1] = -1 };
+
+//The duty cycle (0 - 255), period (ns) and polarity each pin was set to
+int neo_pwm_duty_set[PWMPORTSL + 2];
+int neo_pwm_period_set[PWMPORTSL + 2];
+int neo_pwm_inverted[PWMPORTSL + 2];
+
+//The real pwm files and their caches are shared by every thread
+pthread_mutex_t neo_pwm_real_lock = PTHREAD_MUTEX_INITIALIZER;
 
 //Defaults for period and duty cycles currently set to 49Khz and 50%
 unsigned int neo_pwm_period = 20408;
 unsigned int neo_pwm_duty = 50;
 
-//Couting of the fake pwm list
+//Couting of the fake pwm list, published to the scheduler once the channel is set up
 int neo_pwm_counting = 0;
 
 
 //Double free or nothing error fix and doesn't double initialize
 unsigned char neo_pwm_freed = 2;
 
-//Thread managers that manage the pwm frequency and GPIO switching
-pthread_t fakePWMT[MAXFAKEPWM + 2];
+//The one thread manager that switches the GPIO of every fake pwm channel
+pthread_t fakePWMT;
+int neo_pwm_running = 0;
+int neo_pwm_realtime = 0;
+int neo_pwm_stop = 0;
+
+//How much earlier than a deadline the thread manager goes to sleep for (ns)
+int64_t neo_pwm_lead = 0;
+
+//Bumped for every group so the channels know to line up again
+unsigned int neo_pwm_gen = 0;
+
+//Adding channels from many threads at once
+pthread_mutex_t neo_pwm_lock = PTHREAD_MUTEX_INITIALIZER;
 
 
 #endif
 
-//The struct that will be muxed between the main thread and FAKEPWMMANAGER
-//To handle the current duty cycle and low high periods
+//The timing of a channel, high, low and dead are in microseconds like the period
+struct pwm_timing_h {
+	int high, low;
+	int partner; //Pin driven as the complement of the channel (-1 for none)
+	int dead; //Time both pins are low around each edge of the complement
+	uint64_t epoch, phase; //A grouped channel starts it's periods on epoch + phase + k * period (ns), epoch 0 is free running
+	unsigned int gen; //The group the timing belongs to
+};
+
+//Declare alias for struct
+typedef struct pwm_timing_h pwm_timing_t;
+
+//The struct that will be shared between the main thread and FAKEPWMMANAGER
+//To handle the current duty cycle and low high periods, the timing is published through the seqlock
 struct params {
-	pthread_mutex_t mutex;
-	pthread_cond_t done;
-	int pin, high, low, updatePeriod;
+	unsigned int seq; //Odd while a write is in progress
+	int pin;
+	pwm_timing_t timing; //What the manager reads
+	pwm_timing_t set; //The writers copy (only touched with neo_pwm_lock)
+	int duty, inverted; //What the channel was set to, to map it again when the period or polarity change
+
+	//The measurements of the manager published through their own seqlock @see neo_fake_pwm_stats()
+	unsigned int stat_seq;
+	int reset; //Set by the user to start the measurements over
+	uint64_t pub_periods, pub_period_sum, pub_high_sum, pub_req_period_sum, pub_req_high_sum;
+	uint64_t pub_toggles, pub_jitter_sum, pub_jitter_max;
 };
 
 //Create the new params struct to not confuse locals
@@ -91,6 +150,151 @@ typedef struct params params_t;
 //Doesn't matter)
 params_t threadProps[MAXFAKEPWM + 2];
 
+//What the scheduler knows about each channel, only touched by the FAKEPWMMANAGER
+struct fake_pwm_h {
+	int pin, level; //The channel pin and it's level
+	int partner, plevel; //The complement pin and it's level
+	uint64_t down, pdown; //When the pin and the complement were really pulled low (ns)
+	unsigned int gen; //The group the channel is lined up with
+	uint64_t high, low, dead; //The timing of the current period (ns)
+	uint64_t start, next; //Start of the current period and the next toggle (ns)
+
+	//The writes of the current period, step 0 is the start of the next period
+	int step, steps;
+	int held; //Waiting out the dead time of the complement, the write can't go early
+	uint64_t at[4]; //After the start of the period (ns)
+	int pins[4], levels[4];
+
+	//When the toggles of this period really happened (rise is 0 before the first)
+	uint64_t rise, fall;
+	int fell;
+
+	//Measured since the last reset
+	uint64_t periods, period_sum, high_sum, req_period_sum, req_high_sum;
+	uint64_t toggles, jitter_sum, jitter_max;
+};
+
+//Declare alias for struct
+typedef struct fake_pwm_h fake_pwm_t;
+
+fake_pwm_t neo_pwm_channels[MAXFAKEPWM + 2];
+
+//Min-heap of channel indexes ordered by their next toggle
+int neo_pwm_heap[MAXFAKEPWM + 2];
+
+#endif
+
+#ifndef DOXYGEN_SKIP
+
+//Writes a value to a real pwm file unless it's already the last one written
+int __neo_pwm_sysfs(int fd, long long *last, long long value) {
+	char buff[24];
+	int len;
+
+	if(*last == value) return NEO_OK; //Nothing changes, no syscall
+	if(fd < 0) return NEO_UNUSABLE_ERROR;
+
+	len = sprintf(buff, "%lld", value);
+	if(pwrite(fd, buff, len, 0) != len) {
+		*last = -1; //Don't know what the kernel has anymore
+		return NEO_UNUSABLE_ERROR;
+	}
+	*last = value;
+	return NEO_OK;
+}
+
+//Writes the period and duty of a pin in the order the kernel accepts (the duty can never be above the period)
+int __neo_pwm_apply(int pin, long long period, long long duty) {
+	int ret;
+
+	ret = NEO_OK;
+	//An unknown duty could be above any period, zero never is
+	if(neo_pwm_last_duty[pin] < 0) ret = __neo_pwm_sysfs(pwmD[pin], &neo_pwm_last_duty[pin], 0);
+	//Shrinking below the current duty, the new duty fits in both periods
+	else if(neo_pwm_last_duty[pin] > period) ret = __neo_pwm_sysfs(pwmD[pin], &neo_pwm_last_duty[pin], duty);
+
+	if(ret == NEO_OK) ret = __neo_pwm_sysfs(pwmP[pin], &neo_pwm_last_period[pin], period);
+
+	if(ret == NEO_OK) ret = __neo_pwm_sysfs(pwmD[pin], &neo_pwm_last_duty[pin], duty);
+	return ret;
+}
+
+//Opens a file of an exported pwm, udev can take a moment to hand the new files over
+int __neo_pwm_open(int chip, const char *file) {
+	char path[strlen(PWMPATH) + strlen(file) + 10];
+	int fd, tries;
+
+	sprintf(path, PWMPATH "%s", chip, file);
+	for(tries = 0; tries < PWMOPENTRIES; tries++) {
+		fd = open(path, O_RDWR | O_CLOEXEC);
+		if(fd >= 0) return fd;
+		usleep(PWMOPENWAITUS);
+	}
+	return -1;
+}
+
+//Closes the files of a pwm pin and forgets what was written
+void __neo_pwm_close(int pin) {
+	if(pwmP[pin] >= 0) close(pwmP[pin]);
+	if(pwmD[pin] >= 0) close(pwmD[pin]);
+	if(pwmE[pin] >= 0) close(pwmE[pin]);
+	if(pwmO[pin] >= 0) close(pwmO[pin]);
+	pwmP[pin] = pwmD[pin] = pwmE[pin] = pwmO[pin] = -1;
+	neo_pwm_last_period[pin] = neo_pwm_last_duty[pin] = neo_pwm_last_enable[pin] = neo_pwm_last_polarity[pin] = -1;
+	USABLEPWM[pin] = 0;
+}
+
+//Sets the polarity of a real pwm pin, the kernel only takes it while the pwm is disabled
+int __neo_pwm_polarity(int pin, int inverted) {
+	const char *level = (inverted) ? "inversed" : "normal";
+	int ret;
+
+	if(pwmO[pin] < 0 || neo_pwm_last_polarity[pin] == inverted) return NEO_OK; //Inverted in the duty instead
+	ret = __neo_pwm_sysfs(pwmE[pin], &neo_pwm_last_enable[pin], 0);
+	if(ret != NEO_OK) return ret;
+
+	if(pwrite(pwmO[pin], level, strlen(level), 0) != (ssize_t) strlen(level)) {
+		neo_pwm_last_polarity[pin] = -1;
+		return NEO_UNUSABLE_ERROR;
+	}
+	neo_pwm_last_polarity[pin] = inverted;
+	return NEO_OK;
+}
+
+//Writes what a real pwm pin was set to (callers hold neo_pwm_real_lock), only the changes reach sysfs
+int __neo_pwm_update(int pin) {
+	long long period = neo_pwm_period_set[pin];
+	long long high = period * neo_pwm_duty_set[pin] / 255;
+	int soft = neo_pwm_inverted[pin] && pwmO[pin] < 0; //No polarity file, flip the duty
+	int on, ret;
+
+	if(soft) high = period - high;
+
+	//A disabled pwm sits low, which is only right for a zero duty (or full one when flipped)
+	on = (soft) ? neo_pwm_duty_set[pin] != 255 : (neo_pwm_duty_set[pin] != 0 || neo_pwm_inverted[pin]);
+	if(!on) return __neo_pwm_sysfs(pwmE[pin], &neo_pwm_last_enable[pin], 0);
+
+	ret = __neo_pwm_apply(pin, period, high);
+	if(ret == NEO_OK) ret = __neo_pwm_sysfs(pwmE[pin], &neo_pwm_last_enable[pin], 1);
+	return ret;
+}
+
+//Maps a fake pwm duty cycle (0 - 255) to the high part of a period
+int __neo_fake_pwm_high(int duty, int period, int inverted) {
+	int high = (int) ((int64_t) period * duty / 255);
+	return (inverted) ? period - high : high;
+}
+
+//The duty cycle a real pwm pin was set to, NEO_UNUSABLE_ERROR if it can't be used
+int __neo_pwm_duty(int pin) {
+	int duty;
+
+	pthread_mutex_lock(&neo_pwm_real_lock);
+	duty = (USABLEPWM[pin]) ? neo_pwm_duty_set[pin] : NEO_UNUSABLE_ERROR;
+	pthread_mutex_unlock(&neo_pwm_real_lock);
+	return duty;
+}
+
 #endif
 
 /**
@@ -100,24 +304,23 @@ params_t threadProps[MAXFAKEPWM + 2];
  * It is actually pwm that has a real controller. Although this is not recommended
  * Since it can conflict with the GPIO pin that's also being used
  * 
+ * Every pwmchip is exported and it's period, duty_cycle and enable files are kept open,
+ * the last values written are remembered so writes that don't change anything never reach sysfs
+ * 
  * @return NEO_OK or NEO_EXPORT_ERROR if some PWM weren't initialized
  * 
  * @note Do not use the same GPIO as output or input! It will override this
  * @note NEO_UNUSABLE_ERROR might be returned if that pin doesn't support PWM or it's not mapped using device tree editor 
  */
-int neo_pwm_init(int *pwm_map)
+int neo_pwm_init()
 {
 	int i;
 	int fail;
-	
-	//Double check length of mapping
-	int pwm_l = (sizeof(pwm_map) / sizeof(int)) - 1; //True length since pwm
-	//is shifted
-
-	if(pwm_l + 1 == 0) return NEO_UNUSABLE_EXPORT_ERROR; //Return the mapping is unusable
 
 	fail = NEO_OK; //Return code
 
+	pthread_mutex_lock(&neo_pwm_real_lock);
+
 	//Don't initialize twice
 	if(neo_pwm_freed == 2) {
 		//Setup cleanup on exit of application
@@ -128,81 +331,58 @@ int neo_pwm_init(int *pwm_map)
 
 		//Configure all possible PWM pins
 		for(i = 0; i < PWMPORTSL; i++) {
-			
-			//Check to see if the index exists
-			/*if(pwm_l >= (i)) {
-				if(pwm_map[i]
-			}*/
-			
-			printf("PORT %d", i);
-			
-			continue;
-			
-			FILE *eFile;
-			
-			//Create the new PWM chip export path
-			char nPathfs[strlen(PWMEXPORTPATH) + 10];
-			
-			
-			
-			//Export the PWMCHIP pin to be used with sysfs
-			eFile = fopen(PWMEXPORTPATH, "w");	
-			//If the export completed export that pin number
-			if(eFile != NULL) {
-				//fprintf(eFile, "%s", PWMPORTS[i]);
-				fflush(eFile);
-				USABLEPWM[i] = 1;
-			} else fail = NEO_EXPORT_ERROR;
-	
-	
-			//New char path size fixes, C is sometimes repetitive...
-			//The sizes of the paths can be found in neo.h
-			size_t pwmSize = strlen(PWMPORTS[i]) + pwmL + 5;
-			size_t newPathS = pwmSize + pwmPeriod;
-			size_t newDPathS = pwmSize + pwmDuty;
-			size_t newEPathS = pwmSize + pwmEnable;
-	
-			//Create the new char arrays for the paths to be stored in
-			char buffP[newPathS];
-			char buffD[newDPathS];
-			char buffE[newEPathS];
-	
-			//Combine the paths together into one per PWM pin
-			//And copy them into the above buffer to be later opened and checked
-			//sprintf(buffP, "%s%s%s", PWMPATH, PWMPORTS[i], PWMPERIOD);
-			//sprintf(buffD, "%s%s%s", PWMPATH, PWMPORTS[i], PWMDUTY);
-			//sprintf(buffE, "%s%s%s", PWMPATH, PWMPORTS[i], PWMENABLE);
-	
-			//Load the period into the program
-			pwmP[i] = fopen(buffP, "w");
-	
+			char path[strlen(PWMEXPORTPATH) + 10];
+			int fd;
+
+			__neo_pwm_close(i);
+
+			//Export the first pwm of the PWMCHIP to be used with sysfs (busy means it already is)
+			sprintf(path, PWMEXPORTPATH, PWMPORTS[i]);
+			fd = open(path, O_WRONLY | O_CLOEXEC);
+			if(fd < 0 || (write(fd, "0", 1) != 1 && errno != EBUSY)) {
+				if(fd >= 0) close(fd);
+				fail = NEO_EXPORT_ERROR;
+				continue;
+			}
+			close(fd);
+
+			//Open the period, the duty cycle and the enable(r) of the PWM
+			pwmP[i] = __neo_pwm_open(PWMPORTS[i], PWMPERIOD);
+			pwmD[i] = __neo_pwm_open(PWMPORTS[i], PWMDUTY);
+			pwmE[i] = __neo_pwm_open(PWMPORTS[i], PWMENABLE);
+
 			//If the pwm failed to load, then still the PWM pin is unusable
 			//Set error flag to NEO_UNUSABLE_EXPORT_ERROR (meaning fully disfunctional)
-			if(pwmP[i] != NULL) {
-				fprintf(pwmP[i], "%d", neo_pwm_period);
-				fflush(pwmP[i]);
-			} else { 
-				fail = (fail == NEO_EXPORT_ERROR || fail == NEO_UNUSABLE_EXPORT_ERROR) ? 
-						NEO_UNUSABLE_EXPORT_ERROR : NEO_UNUSABLE_ERROR; 
-				USABLEPWM[i] = 0;
-			}
-	
-			//Try the same for Duty cycle and the enable(r) of PWM
-			pwmD[i] = fopen(buffD, "w");
-			pwmE[i] = fopen(buffE, "w");
-	
-			if(pwmD[i] == NULL || pwmE[i] == NULL) {
+			if(pwmP[i] < 0 || pwmD[i] < 0 || pwmE[i] < 0) {
 				fail = (fail == NEO_EXPORT_ERROR || fail == NEO_UNUSABLE_EXPORT_ERROR) ? 
 						NEO_UNUSABLE_EXPORT_ERROR : NEO_UNUSABLE_ERROR; 
-				USABLEPWM[i] = 0;
+				__neo_pwm_close(i);
 				continue;
 			}
-			
-			neo_pwm_set_period(i, neo_pwm_period); //Set the default 49KHz for all the pins
+
+			//Not every kernel lets the polarity change, those get it flipped in the duty
+			char polarity[strlen(PWMPATH) + strlen(PWMPOLARITY) + 10];
+			sprintf(polarity, PWMPATH PWMPOLARITY, PWMPORTS[i]);
+			pwmO[i] = open(polarity, O_RDWR | O_CLOEXEC);
+
+			USABLEPWM[i] = 1;
+			neo_pwm_duty_set[i] = 0;
+			neo_pwm_period_set[i] = neo_pwm_period;
+			neo_pwm_inverted[i] = 0;
+
+			//Start disabled on the default 49KHz for all the pins
+			if(__neo_pwm_sysfs(pwmE[i], &neo_pwm_last_enable[i], 0) != NEO_OK 
+					|| __neo_pwm_polarity(i, 0) != NEO_OK
+					|| __neo_pwm_apply(i, neo_pwm_period, 0) != NEO_OK) {
+				fail = NEO_UNUSABLE_ERROR;
+				__neo_pwm_close(i);
+			}
 		}
 		//Set the global flag to see if PWM is initialized
 		neo_pwm_freed = 0;	
 	}
+
+	pthread_mutex_unlock(&neo_pwm_real_lock);
 	return fail;
 }
 
@@ -212,87 +392,444 @@ int neo_pwm_init(int *pwm_map)
 /*
  * Backend function to control the synchronization of the thread muxing for
  * the params_t struct. All args are pointers since it's called within the 
- * FAKEPWMMANAGER thread
+ * FAKEPWMMANAGER thread. It never takes a lock, a copy that overlapped a write is just taken again
  */
-void neo_sync_pwm(void *arg, int *pin, int *high, int *low,
-		int *updatePeriod) {
-	//Lock onto main thread to gain the struct via the params_t struct mutex
-	pthread_mutex_lock(&(*(params_t*)(arg)).mutex);
+void neo_sync_pwm(void *arg, int *pin, struct pwm_timing_h *timing) {
+	params_t *sets = (params_t*) arg;
+	unsigned int seq;
+
+	do { //Retry until the whole timing comes from the same write
+		seq = __atomic_load_n(&sets->seq, __ATOMIC_ACQUIRE);
+		timing->high = __atomic_load_n(&sets->timing.high, __ATOMIC_RELAXED);
+		timing->low = __atomic_load_n(&sets->timing.low, __ATOMIC_RELAXED);
+		timing->partner = __atomic_load_n(&sets->timing.partner, __ATOMIC_RELAXED);
+		timing->dead = __atomic_load_n(&sets->timing.dead, __ATOMIC_RELAXED);
+		timing->epoch = __atomic_load_n(&sets->timing.epoch, __ATOMIC_RELAXED);
+		timing->phase = __atomic_load_n(&sets->timing.phase, __ATOMIC_RELAXED);
+		timing->gen = __atomic_load_n(&sets->timing.gen, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	} while((seq & 1) || seq != __atomic_load_n(&sets->seq, __ATOMIC_RELAXED));
+
+	*pin = sets->pin; //Never changes once the channel is handed over
+}
+
+//Publishes the writers copy of the timing of a channel to the FAKEPWMMANAGER (writers hold neo_pwm_lock)
+void __neo_pwm_publish(params_t *sets) {
+	unsigned int seq = sets->seq;
+
+	__atomic_store_n(&sets->seq, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	__atomic_store_n(&sets->timing.high, sets->set.high, __ATOMIC_RELAXED);
+	__atomic_store_n(&sets->timing.low, sets->set.low, __ATOMIC_RELAXED);
+	__atomic_store_n(&sets->timing.partner, sets->set.partner, __ATOMIC_RELAXED);
+	__atomic_store_n(&sets->timing.dead, sets->set.dead, __ATOMIC_RELAXED);
+	__atomic_store_n(&sets->timing.epoch, sets->set.epoch, __ATOMIC_RELAXED);
+	__atomic_store_n(&sets->timing.phase, sets->set.phase, __ATOMIC_RELAXED);
+	__atomic_store_n(&sets->timing.gen, sets->set.gen, __ATOMIC_RELAXED);
+	__atomic_store_n(&sets->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+//Current CLOCK_MONOTONIC time in nanoseconds
+uint64_t __neo_pwm_now() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+//Moves a heap entry towards the root while it's due before it's parent
+void __neo_pwm_heap_up(int ind) {
+	while(ind > 0) {
+		int parent = (ind - 1) / 2;
+		if(neo_pwm_channels[neo_pwm_heap[parent]].next <= neo_pwm_channels[neo_pwm_heap[ind]].next) break;
+
+		int swap = neo_pwm_heap[parent];
+		neo_pwm_heap[parent] = neo_pwm_heap[ind];
+		neo_pwm_heap[ind] = swap;
+		ind = parent;
+	}
+}
+
+//Moves a heap entry towards the leaves while a child is due before it
+void __neo_pwm_heap_down(int ind, int size) {
+	while(1) {
+		int first = ind, left = 2 * ind + 1, right = left + 1;
+
+		if(left < size && neo_pwm_channels[neo_pwm_heap[left]].next < neo_pwm_channels[neo_pwm_heap[first]].next) first = left;
+		if(right < size && neo_pwm_channels[neo_pwm_heap[right]].next < neo_pwm_channels[neo_pwm_heap[first]].next) first = right;
+		if(first == ind) break;
+
+		int swap = neo_pwm_heap[first];
+		neo_pwm_heap[first] = neo_pwm_heap[ind];
+		neo_pwm_heap[ind] = swap;
+		ind = first;
+	}
+}
+
+//Hands the measurements of a channel to neo_fake_pwm_stats
+void __neo_pwm_publish_stats(params_t *sets, fake_pwm_t *ch) {
+	unsigned int seq = sets->stat_seq;
+
+	__atomic_store_n(&sets->stat_seq, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	__atomic_store_n(&sets->pub_periods, ch->periods, __ATOMIC_RELAXED);
+	__atomic_store_n(&sets->pub_period_sum, ch->period_sum, __ATOMIC_RELAXED);
+	__atomic_store_n(&sets->pub_high_sum, ch->high_sum, __ATOMIC_RELAXED);
+	__atomic_store_n(&sets->pub_req_period_sum, ch->req_period_sum, __ATOMIC_RELAXED);
+	__atomic_store_n(&sets->pub_req_high_sum, ch->req_high_sum, __ATOMIC_RELAXED);
+	__atomic_store_n(&sets->pub_toggles, ch->toggles, __ATOMIC_RELAXED);
+	__atomic_store_n(&sets->pub_jitter_sum, ch->jitter_sum, __ATOMIC_RELAXED);
+	__atomic_store_n(&sets->pub_jitter_max, ch->jitter_max, __ATOMIC_RELAXED);
+	__atomic_store_n(&sets->stat_seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+//Writes a pin of a channel if it isn't at that level already
+void __neo_pwm_set(fake_pwm_t *ch, int pin, int level) {
+	int mine = (pin == ch->pin);
+	int *cur = (mine) ? &ch->level : &ch->plevel;
+
+	if(*cur == level) return;
+	neo_gpio_digital_write_no_safety(&pin, level);
+	*cur = level;
+	if(level == LOW) *((mine) ? &ch->down : &ch->pdown) = __neo_pwm_now();
+}
 
-	//Loaded params_t struct from teh void pointer in arg
-	params_t sets = (*(params_t*)(arg));
+//The earliest a write of a complementary channel may happen (ns), 0 for any time
+uint64_t __neo_pwm_safe(fake_pwm_t *ch, int pin, int level) {
+	int mine = (pin == ch->pin);
 
-	*pin = sets.pin;
-	*high = sets.high;
-	*low = sets.low;
-	*updatePeriod = sets.updatePeriod;
+	if(level != HIGH || ch->partner < 0 || ((mine) ? ch->level : ch->plevel) == HIGH) return 0;
 
-	//Unlock the struct from the main thread
-	pthread_mutex_unlock(&(*(params_t*)(arg)).mutex);
+	//The dead time counts from when the other pin really went low, toggles can be early or late
+	return ((mine) ? ch->pdown : ch->down) + ch->dead;
+}
+
+//Adds a write to the current period of a channel
+void __neo_pwm_add(fake_pwm_t *ch, uint64_t at, int pin, int level) {
+	ch->at[ch->steps] = at;
+	ch->pins[ch->steps] = pin;
+	ch->levels[ch->steps] = level;
+	ch->steps++;
+}
+
+//Sets up the next period of a channel, returns 0 if it has to wait for it's group first
+int __neo_pwm_period(fake_pwm_t *ch, uint64_t now, uint64_t done) {
+	params_t *sets = &threadProps[ch - neo_pwm_channels];
+	uint64_t due = ch->next, high_ns = ch->high, low_ns = ch->low; //The period that's ending
+	int level = ch->level;
+	pwm_timing_t t;
+
+	//Pick up the new timing at the start of each period
+	neo_sync_pwm(sets, &ch->pin, &t);
+	ch->high = (uint64_t) t.high * 1000ULL; //The period has always been slept in microseconds
+	ch->low = (uint64_t) t.low * 1000ULL;
+	ch->dead = (uint64_t) t.dead * 1000ULL;
+	uint64_t period = ch->high + ch->low;
+
+	if(period == 0) { //Not set up yet, look again later
+		__neo_pwm_set(ch, ch->pin, LOW);
+		ch->next = now + PWMSLICENS;
+		ch->rise = 0;
+		return 0;
+	}
+
+	if(t.gen != ch->gen) { //Joined a group, the complement might have changed
+		ch->gen = t.gen;
+		if(ch->partner != t.partner) {
+			if(ch->partner >= 0) __neo_pwm_set(ch, ch->partner, LOW);
+			ch->partner = t.partner;
+			ch->plevel = HIGH; //Unknown, force the first write
+			if(ch->partner >= 0) __neo_pwm_set(ch, ch->partner, LOW);
+		}
+
+		//Wait low for the next period start on the grid of the group
+		uint64_t grid = t.epoch + t.phase;
+		if(t.epoch != 0 && grid != due) {
+			ch->next = (due < grid) ? grid : grid + ((due - grid + period - 1) / period) * period;
+			__neo_pwm_set(ch, ch->pin, LOW);
+			if(ch->partner >= 0) __neo_pwm_set(ch, ch->partner, LOW);
+			ch->rise = 0; //Don't measure the odd period
+			return 0;
+		}
+	}
+
+	//Fell more than a period behind, skip the missed periods instead of rushing through them (keeps the phase)
+	ch->start = (due + period < now) ? due + ((now - due) / period) * period : due;
+
+	//Measure the period that just ended from when it's toggles really happened
+	if(__atomic_exchange_n(&sets->reset, 0, __ATOMIC_ACQUIRE)) {
+		ch->periods = ch->period_sum = ch->high_sum = ch->req_period_sum = ch->req_high_sum = 0;
+		ch->toggles = ch->jitter_sum = ch->jitter_max = 0;
+		ch->rise = 0;
+	} else if(ch->rise != 0) {
+		uint64_t span = done - ch->rise;
+
+		ch->periods++;
+		ch->period_sum += span;
+		if(ch->fell) ch->high_sum += ch->fall - ch->rise;
+		else if(level == HIGH) ch->high_sum += span; //Stayed high the whole period
+		ch->req_period_sum += high_ns + low_ns;
+		ch->req_high_sum += high_ns;
+	}
+	ch->rise = done;
+	ch->fell = 0;
+
+	//A full or empty duty cycle never toggles inside the period
+	ch->step = ch->steps = 0;
+	__neo_pwm_add(ch, 0, ch->pin, (ch->high > 0) ? HIGH : LOW);
+	if(ch->high > 0 && ch->low > 0) __neo_pwm_add(ch, ch->high, ch->pin, LOW);
+
+	//The complement goes high dead after the channel falls and low dead before it rises again
+	if(ch->partner >= 0 && ch->low > 2 * ch->dead) {
+		__neo_pwm_add(ch, ch->high + ch->dead, ch->partner, HIGH);
+		__neo_pwm_add(ch, period - ch->dead, ch->partner, LOW);
+	}
+	return 1;
+}
+
+//Does the writes a channel is due for and works out when the next ones are, returns how late it was (ns)
+int64_t __neo_pwm_toggle(fake_pwm_t *ch, uint64_t now) {
+	params_t *sets = &threadProps[ch - neo_pwm_channels];
+	uint64_t due = ch->next, done = __neo_pwm_now();
+
+	if(ch->step == 0 && !ch->held && !__neo_pwm_period(ch, now, done)) return (int64_t) (done - due);
+	ch->held = 0;
+
+	//Every write sharing the same time goes out together
+	uint64_t at = ch->at[ch->step];
+	int fell = 0;
+	while(ch->step < ch->steps && ch->at[ch->step] == at) {
+		uint64_t safe = __neo_pwm_safe(ch, ch->pins[ch->step], ch->levels[ch->step]);
+
+		//Too close to the fall of the other pin, come back for it at the end of the dead time instead of spinning
+		if(safe > done && safe > (done = __neo_pwm_now())) {
+			ch->next = safe;
+			ch->held = 1;
+			if(fell) {
+				ch->fall = done;
+				ch->fell = 1;
+			}
+			return 0; //Not a wake up the lead should learn from
+		}
+
+		__neo_pwm_set(ch, ch->pins[ch->step], ch->levels[ch->step]);
+		if(at > 0 && ch->pins[ch->step] == ch->pin) fell = 1; //The only write of the pin inside the period is it's fall
+		ch->step++;
+	}
+	done = __neo_pwm_now();
+
+	if(fell) {
+		ch->fall = done;
+		ch->fell = 1;
+	}
+
+	if(ch->step >= ch->steps) {
+		ch->step = 0;
+		ch->next = ch->start + ch->high + ch->low;
+	} else ch->next = ch->start + ch->at[ch->step];
+
+	//Early and late both count as jitter
+	int64_t late = (int64_t) (done - due);
+	uint64_t jitter = (late < 0) ? (uint64_t) -late : (uint64_t) late;
+	ch->toggles++;
+	ch->jitter_sum += jitter;
+	if(jitter > ch->jitter_max) ch->jitter_max = jitter;
+
+	if(at == 0) __neo_pwm_publish_stats(sets, ch); //Once a period is enough
+	return late;
 }
 
 /*
- * This is the thread that will be created everytime the user inits a new
- * FAKEPWM_WRITE on a new GPIO pin that doesn't exists. From there the write method
- * Will check all the params struct to see if the pin already exists and attempt to update that struct
- * Of which the thread manager should update within 17% of the millis period time (On 49Hz) That's 200 millis (A little slow)
+ * This is the one thread that runs every fake pwm channel. It's started by the
+ * first FAKEPWM_WRITE and picks up the channels added after that on it's next wake up.
+ * The channel due first is always on top of the heap, so each toggle is one write and a sift
+ * and the thread sleeps to the absolute time of the next one (never longer than PWMSLICENS).
+ * It goes to sleep neo_pwm_lead early, the lead follows how late the first toggle after each
+ * wake up was, so on average the toggles land on their deadlines
  */
-void *pwmManager(void *arg){
-	int pin, high, low; //Pin settings for params sync
-	
-	//counter for update period and global setting for params sync
-	//BEFORE: unsigned long long (unecessary)
-	int counter, updatePeriod;
+void *pwmManager(void *arg) {
+	struct timespec wake;
+	int size = 0;
+	(void) arg;
+
+	while(!__atomic_load_n(&neo_pwm_stop, __ATOMIC_ACQUIRE)) {
+		uint64_t now = __neo_pwm_now();
+		int count = __atomic_load_n(&neo_pwm_counting, __ATOMIC_ACQUIRE);
+		int first = 1;
+
+		//Start the new channels right away, the pin was already set low by the write
+		while(size < count) {
+			fake_pwm_t *ch = &neo_pwm_channels[size];
+			memset(ch, 0, sizeof(fake_pwm_t));
+			ch->pin = threadProps[size].pin;
+			ch->level = LOW;
+			ch->partner = -1;
+			ch->next = now;
+
+			neo_pwm_heap[size] = size;
+			__neo_pwm_heap_up(size);
+			size++;
+		}
 
-	//Initial sync of settings since usuably write has completed by now
-	neo_sync_pwm(arg, &pin, &high, &low, &updatePeriod);
-	
-	//No other debug method but printing
-	//This should be a flag, for now it works
-	//@TODO change debug of FAKEPWMMANAGER to a flag
-	printf("FAKE PWM PORT: %d\n", pin);
+		//Toggle everything that's due (or due before the thread could wake up again), a held write is never early
+		while(size > 0 && neo_pwm_channels[neo_pwm_heap[0]].next 
+				<= now + ((neo_pwm_channels[neo_pwm_heap[0]].held) ? 0 : (uint64_t) neo_pwm_lead)) {
+			int64_t late = __neo_pwm_toggle(&neo_pwm_channels[neo_pwm_heap[0]], now);
+			__neo_pwm_heap_down(0, size);
+
+			//Only the first toggle shows the wake up, the others waited on the writes before them
+			if(first) {
+				neo_pwm_lead += late / 8;
+				if(neo_pwm_lead < 0) neo_pwm_lead = 0;
+				if(neo_pwm_lead > PWMLEADNS) neo_pwm_lead = PWMLEADNS;
+				first = 0;
+			}
+		}
 
-	//Star the pin in low and set the pinMode to output for safety
-	int retM = neo_gpio_pin_mode(pin, OUTPUT);
-	int remR = neo_gpio_digital_write(pin, 0);
-
-
-	/*
-	If either the pin_mode or digital_write fail on us... Do not continue!
-	It's crucial not to continue because it either means the GPIO are already
-	In use or that the pin failed to initialize. There is no safety pased this point
-	Better stop the FAKEPWMMANAGER now and just print an error, so the user can see it failed
-	*/
-	if(retM != NEO_OK) {
-		printf("FAKE PWM FAILURE, COULDN'T EXPORT PIN!\n\n");
-		return NULL;
+		//Sleep to the next toggle, in slices so new channels and the stop don't wait a whole period
+		uint64_t until = now + PWMSLICENS;
+		if(size > 0) {
+			fake_pwm_t *top = &neo_pwm_channels[neo_pwm_heap[0]];
+			uint64_t at = top->next - ((top->held) ? 0 : (uint64_t) neo_pwm_lead);
+			if(at < until) until = at;
+		}
+
+		wake.tv_sec = until / 1000000000ULL;
+		wake.tv_nsec = until % 1000000000ULL;
+		while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL) == EINTR);
 	}
+	return NULL;
+}
+
+//Starts the thread manager, SCHED_FIFO when allowed
+int __neo_pwm_start() {
+	struct sched_param param;
+	pthread_attr_t attr;
+	int ret;
+
+	if(neo_pwm_running) return NEO_OK;
 
-	if(remR != NEO_OK) {
-		printf("FAKE PWM FAILURE, COULDN'T LOWER PIN");
-		return NULL;
+	__atomic_store_n(&neo_pwm_stop, 0, __ATOMIC_RELEASE);
+	pthread_attr_init(&attr);
+	pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+	pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+	param.sched_priority = PWMPRIORITY;
+	pthread_attr_setschedparam(&attr, &param);
+
+	ret = pthread_create(&fakePWMT, &attr, pwmManager, NULL);
+	pthread_attr_destroy(&attr);
+	neo_pwm_realtime = (ret == 0);
+	if(ret == EPERM) ret = pthread_create(&fakePWMT, NULL, pwmManager, NULL);
+	if(ret != 0) return NEO_FAIL;
+
+	neo_pwm_running = 1;
+	return NEO_OK;
+}
+
+//Finds the channel of a pin (callers hold neo_pwm_lock), -1 if there isn't one
+int __neo_pwm_find(int pin) {
+	int i;
+
+	for(i = 0; i < neo_pwm_counting; i++) {
+		if(FAKEPWMLIST[i][0] == pin) return i;
 	}
-	printf("STARTING FAKE PWM MANAGER ON PIN: %d\n", pin);
-	
-	//Set the current pin update counter
-	counter = 0;
-	//Loop forever until the thread manager is killed via a sleep interrupt
-	while(1) {
-		//The update period is calculated on fake_pwm_write @see neo_fake_pwm_write_period for more details
-		if(counter > updatePeriod) {
-			neo_sync_pwm(arg, &pin, &high, &low, &updatePeriod);
-			counter = 0;
-		}
-		counter++;
-		//The no safety option makes the write faster since it's not checking
-		neo_gpio_digital_write_no_safety(&pin, HIGH); //Pull the duty cycle high
-		if(usleep(high) != 0) break; //Wait for the high part of duty cycle to finish
-		//For anything just writing to the pin
-		//If error happens then a segmentation fault must have occured on writing
-		//To a NULL pin
-		neo_gpio_digital_write_no_safety(&pin, LOW); //Pull the duty cycle to low
-		if(usleep(low) != 0) break; //Make sure low finished (usleep is slightly off but doesn't eat 100% CPU (not a CPU cycle counter)
+	return -1;
+}
+
+//Finds the channel driving a pin as it's complement (callers hold neo_pwm_lock), -1 if none is
+int __neo_pwm_owner(int pin) {
+	int i;
+
+	for(i = 0; i < neo_pwm_counting; i++) {
+		if(threadProps[i].set.partner == pin) return i;
+	}
+	return -1;
+}
+
+//Creates a channel (callers hold neo_pwm_lock), returns it's index or the error
+int __neo_pwm_channel(int pin, int high, int low) {
+	int curI = neo_pwm_counting, ret;
+
+	if(curI >= MAXFAKEPWM) return NEO_EXPORT_ERROR;
+	if(__neo_pwm_owner(pin) >= 0) return NEO_PIN_ERROR; //Already driven as a complement
+
+	//Star the pin in low and set the pinMode to output for safety
+	ret = neo_gpio_pin_mode(pin, OUTPUT);
+	if(ret == NEO_OK) ret = neo_gpio_digital_write(pin, LOW);
+	if(ret == NEO_OK) ret = __neo_pwm_start();
+	if(ret != NEO_OK) return ret;
+
+	//Set the parameters (self explanatory)
+	memset(&threadProps[curI], 0, sizeof(params_t));
+	threadProps[curI].pin = pin;
+	threadProps[curI].set.partner = threadProps[curI].timing.partner = -1;
+	threadProps[curI].set.high = threadProps[curI].timing.high = high;
+	threadProps[curI].set.low = threadProps[curI].timing.low = low;
+
+	//Update the fake PWM list to the currently selected GPIO to update the thread manager checking
+	FAKEPWMLIST[curI][0] = pin;
+	FAKEPWMLIST[curI][1] = curI;
+	__atomic_store_n(&neo_pwm_counting, curI + 1, __ATOMIC_RELEASE); //Hand the channel to the manager
+	return curI;
+}
+
+//Sets a channel up (callers hold neo_pwm_lock), a period of 0 and a duty or inverted of -1 keep what the channel has
+int __neo_fake_pwm_update(int pin, int period, int duty, int inverted) {
+	int ind = __neo_pwm_find(pin), high;
+
+	if(ind >= 0) {
+		params_t *sets = &threadProps[ind];
+
+		//Grouped channels keep the period of the group
+		if(period <= 0 || sets->set.epoch != 0) period = sets->set.high + sets->set.low;
+		if(duty < 0) duty = sets->duty;
+		if(inverted < 0) inverted = sets->inverted;
+
+		//Update the props to be picked up by the manager on the next period
+		high = __neo_fake_pwm_high(duty, period, inverted);
+		sets->set.high = high;
+		sets->set.low = period - high;
+		sets->duty = duty;
+		sets->inverted = inverted;
+		__neo_pwm_publish(sets);
+		return NEO_OK;
+	}
+
+	//A new channel starts on the default period at 0 duty
+	if(period <= 0) period = FAKEPWMPERIOD;
+	if(duty < 0) duty = 0;
+	if(inverted < 0) inverted = 0;
+
+	high = __neo_fake_pwm_high(duty, period, inverted);
+	ind = __neo_pwm_channel(pin, high, period - high); //Create a new one mapped with a params_t struct
+	if(ind < 0) return ind;
+
+	threadProps[ind].duty = duty;
+	threadProps[ind].inverted = inverted;
+	return NEO_OK;
+}
+
+//The duty cycle a fake pwm pin was set to, 0 if it has no channel
+int __neo_fake_pwm_duty(int pin) {
+	int ind, duty;
+
+	pthread_mutex_lock(&neo_pwm_lock);
+	ind = __neo_pwm_find(pin);
+	duty = (ind >= 0) ? threadProps[ind].duty : 0;
+	pthread_mutex_unlock(&neo_pwm_lock);
+	return duty;
+}
+
+//Stops the thread manager and forgets every channel (called by neo_gpio_free)
+void __neo_fake_pwm_free() {
+	pthread_mutex_lock(&neo_pwm_lock);
+	if(neo_pwm_running) {
+		__atomic_store_n(&neo_pwm_stop, 1, __ATOMIC_RELEASE);
+		pthread_join(fakePWMT, NULL);
+		neo_pwm_running = 0;
 	}
+
+	__atomic_store_n(&neo_pwm_counting, 0, __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&neo_pwm_lock);
 }
 
 #endif
@@ -312,117 +849,258 @@ int neo_fake_pwm_init() {
 /**
  * @brief Main write method for fake_pwm
  * 
- * Thise will create a new FAKEPWMMANAGER thread on the selected bank GPIO pin
- * The manager will only be created if there isn't one already on that pin. So don't worry about
+ * Thise will add a new channel on the selected bank GPIO pin to the FAKEPWMMANAGER thread
+ * The channel will only be created if there isn't one already on that pin. So don't worry about
  * Calling this method multiple times. Actually do it when you want to update the duty cycle.
+ * The new duty cycle is picked up at the start of the next period and the period becomes the one of the channel.
  * @see neo_fake_pwm_write 
  * If you want to see the regular duty cycle update. The second argument is period.
  * 
  * @param gpioPin The gpio bank pin to set or update the fake pwm manager on
- * @param period The nano second update time for the period
+ * @param period The period in micro seconds
  * @param duty The duty cycle percentage between 0 and 255 (Like arduino)
  * 
- * @return NEO_OK/NEO_DUTY_ERROR or NEO_PIN_ERROR if the params are wrong
+ * @return NEO_OK/NEO_DUTY_ERROR/NEO_PERIOD_ERROR or NEO_PIN_ERROR if the params are wrong or the pin is a complement, NEO_EXPORT_ERROR when all MAXFAKEPWM channels are used
  * 
- * @note The period argument is in nano second update time for period so 1000000000 would be 1Hz (Aka 1 loop per second)
+ * @note Unlike the real pwm the period argument is in micro seconds, so 1000000 would be 1Hz (Aka 1 loop per second)
  */
 int neo_fake_pwm_write_period(int gpioPin, int period, int duty) {
-	int i;
-	char passed;
+	int ret;
 
 	//Check to see if either the pin or the duty cycle are off
-	if(gpioPin < 0 || gpioPin > GPIOPORTSL) return NEO_PIN_ERROR;
+	if(gpioPin < 0 || gpioPin >= GPIOPORTSL) return NEO_PIN_ERROR;
 	if(duty < 0 || duty > 255) return NEO_DUTY_ERROR;
+	if(period <= 0) return NEO_PERIOD_ERROR;
 
-	//Remap the allowed duty cycle between 0 and 255 to the max of period
-	//This is for the higher duty cycle sleep time
-	int remap = (int) neo_re_map((float)duty, 0.0f, 255.0f, 0.0f,(float)period);
-	//Set the lower duty cycle sleep time to the exact opposite of requested high
-	int lower = (period - remap);
-	//Set the update period of the pin to a static percentage for the same time everytime usually 200 millis
-	int upPeriod = (int)(PWMMUTEXRATE * ((float)period)); 
-
-	passed = 1;
-	//Check to see if there is already a thread manager on the pin
-	for(i = 0; i < MAXFAKEPWM; i++) {
-		//Check to see if the sysfs isn't NULL
-		if(FAKEPWMLIST[i] != NULL) {
-			//Check the params_t struct LIST checker to see if the pin is already mapped
-			if(FAKEPWMLIST[i][0] == gpioPin) {
-				//The thread manager has been found
-				passed = 0;					
-
-				//Pull the threadManagerProperty from the FAKEPWMLIST
-				params_t paramL = threadProps[i]; 
-			
-
-				//pthread_mutex_lock(&paramL.mutex);
-
-				//Update the props to be later locked by the manager thread
-				paramL.pin = gpioPin;
-				paramL.high = remap;
-				paramL.low = lower;
-				paramL.updatePeriod = upPeriod; //20 Cycles
-
-				//Double check and set the LIST to the current pin
-				FAKEPWMLIST[i][0] = gpioPin;
-				FAKEPWMLIST[i][1] = i;
-
-				//Set the update paramProp pointer to be locked by thread manager on pthread
-				threadProps[i] = paramL;
-
-				//pthread_cond_wait (&paramL.done, &paramL.mutex);
-				//pthread_mutex_unlock(&paramL.mutex);
-			}
+	pthread_mutex_lock(&neo_pwm_lock);
+	ret = __neo_fake_pwm_update(gpioPin, period, duty, -1);
+	pthread_mutex_unlock(&neo_pwm_lock);
+	return ret; //Return NEO_OK on completion of write
+}
+
+/**
+ * @brief Sets the period of a single fake pwm channel
+ * 
+ * Every channel runs on it's own period, so a slow servo and a fast led can share the thread manager.
+ * The channel keeps it's duty cycle and polarity on the new period, a pin without a channel gets one at 0 duty
+ * 
+ * @param gpioPin The gpio bank pin of the channel
+ * @param period The period of the channel in micro seconds
+ * 
+ * @return NEO_OK/NEO_PERIOD_ERROR or NEO_PIN_ERROR if the params are wrong or the pin is a complement, 
+ * NEO_PERIOD_ERROR for a grouped channel and NEO_EXPORT_ERROR when all MAXFAKEPWM channels are used
+ * 
+ * @note Grouped channels keep the period of the group, group the pins again to change it @see neo_fake_pwm_group()
+ */
+int neo_fake_pwm_set_period(int gpioPin, int period) {
+	int ind, ret;
+
+	if(gpioPin < 0 || gpioPin >= GPIOPORTSL) return NEO_PIN_ERROR;
+	if(period <= 0) return NEO_PERIOD_ERROR;
+
+	pthread_mutex_lock(&neo_pwm_lock);
+	ind = __neo_pwm_find(gpioPin);
+	if(ind >= 0 && threadProps[ind].set.epoch != 0) ret = NEO_PERIOD_ERROR;
+	else ret = __neo_fake_pwm_update(gpioPin, period, -1, -1);
+	pthread_mutex_unlock(&neo_pwm_lock);
+	return ret;
+}
+
+/**
+ * @brief Sets the polarity of a single fake pwm channel
+ * 
+ * An inverted channel is low for the duty cycle and high for the rest of the period, so
+ * 0 holds the pin high and 255 holds it low. The channel keeps it's duty cycle and period,
+ * a pin without a channel gets one at 0 duty
+ * 
+ * @param gpioPin The gpio bank pin of the channel
+ * @param inverted 1 for an active low channel, 0 for the normal active high one
+ * 
+ * @return NEO_OK or NEO_PIN_ERROR if the pin is wrong or a complement, NEO_EXPORT_ERROR when all MAXFAKEPWM channels are used
+ */
+int neo_fake_pwm_set_polarity(int gpioPin, int inverted) {
+	int ret;
+
+	if(gpioPin < 0 || gpioPin >= GPIOPORTSL) return NEO_PIN_ERROR;
+
+	pthread_mutex_lock(&neo_pwm_lock);
+	ret = __neo_fake_pwm_update(gpioPin, 0, -1, (inverted) ? 1 : 0);
+	pthread_mutex_unlock(&neo_pwm_lock);
+	return ret;
+}
+
+/**
+ * @brief Locks fake pwm channels together on one period
+ * 
+ * Every pin gets a channel on the same period (the ones that didn't have one start at 0 duty) and
+ * every period of each channel starts at a fixed phase of the group, the thread manager keeps them
+ * there cycle to cycle. NEO_PWM_ALIGNED starts every channel at the same time, NEO_PWM_STAGGERED
+ * spreads the starts evenly over the period so they don't all pull current at once.
+ * NEO_PWM_COMPLEMENTARY takes two pins, the second is driven as the inverse of the first with both low
+ * for dead around each edge (a half bridge), it follows the duty cycle written to the first pin.
+ * 
+ * The duty of each channel is still set with neo_fake_pwm_write(), the duty already set on a channel is kept.
+ * The channels line up on their next period, until then they're held low
+ * 
+ * @param pins The gpio bank pins of the group
+ * @param n The amount of pins (2 for NEO_PWM_COMPLEMENTARY)
+ * @param period The period of the group in micro seconds
+ * @param mode NEO_PWM_ALIGNED, NEO_PWM_STAGGERED or NEO_PWM_COMPLEMENTARY
+ * @param dead The time both pins are low for NEO_PWM_COMPLEMENTARY in micro seconds (ignored otherwise)
+ * 
+ * @return NEO_OK, NEO_PIN_ERROR if a pin is wrong or taken, NEO_PERIOD_ERROR if the period or dead time is wrong,
+ * NEO_FAIL for a wrong mode or NEO_EXPORT_ERROR when all MAXFAKEPWM channels are used
+ * 
+ * @note While grouped the period passed to neo_fake_pwm_write_period() is ignored, group the pins again to change it
+ */
+int neo_fake_pwm_group(const int *pins, int n, int period, int mode, int dead) {
+	int ind, i, j, channels;
+
+	if(pins == NULL || n <= 0 || n > MAXFAKEPWM) return NEO_PIN_ERROR;
+	if(mode != NEO_PWM_ALIGNED && mode != NEO_PWM_STAGGERED && mode != NEO_PWM_COMPLEMENTARY) return NEO_FAIL;
+	if(period <= 0) return NEO_PERIOD_ERROR;
+	if(mode == NEO_PWM_COMPLEMENTARY) {
+		if(n != 2) return NEO_PIN_ERROR;
+		if(dead < 0 || dead >= period / 2) return NEO_PERIOD_ERROR;
+	} else dead = 0;
+
+	//The complement isn't a channel, it's written by the channel of the first pin
+	channels = (mode == NEO_PWM_COMPLEMENTARY) ? 1 : n;
+
+	pthread_mutex_lock(&neo_pwm_lock);
+
+	//Check every pin before anything changes
+	for(i = 0; i < n; i++) {
+		int owner = __neo_pwm_owner(pins[i]);
+
+		if(pins[i] < 0 || pins[i] >= GPIOPORTSL) owner = -2;
+		for(j = 0; j < i; j++) {
+			if(pins[j] == pins[i]) owner = -2;
+		}
+
+		//Only the channel of this complement can already be driving it
+		if(i >= channels && (__neo_pwm_find(pins[i]) >= 0 || (owner >= 0 && owner != __neo_pwm_find(pins[0])))) owner = -2;
+		if(i < channels && owner >= 0) owner = -2;
+
+		if(owner == -2) {
+			pthread_mutex_unlock(&neo_pwm_lock);
+			return NEO_PIN_ERROR;
 		}
 	}
 
-	//If the FAKEPWMLIST couldn't find a pwm manager create a new one mapped with a params_t struct
-	if(passed) {
-		int curI = neo_pwm_counting;
-		if(curI > MAXFAKEPWM) return NEO_EXPORT_ERROR;
-		
-		//Create the new params_t and set the parameters (self explanatory)
-		params_t initP;
-		initP.pin = gpioPin;
-		initP.high = remap;
-		initP.low = lower;
-		initP.updatePeriod = upPeriod;
-
-		//Update the global array
-		threadProps[curI] = initP;	
-
-		//Start the mutex locker on the pthread with the params_t mutex locker
-		pthread_mutex_init(&threadProps[curI].mutex , NULL);
-		//pthread_cond_init(&threadProps[curI].done, NULL);
-		//pthread_mutex_lock(&threadProps[curI].mutex);
-
-		//Create the new thread with the pointer to the pointing array for the params_t
-		pthread_create(&fakePWMT[curI], NULL, pwmManager, &threadProps[curI]);
-		//pthread_cond_wait (&threadProps[curI].done, &threadProps[curI].mutex);
-		
-		//Update the fake PWM list to the currently selected GPIO to update the thread manager checking
-		FAKEPWMLIST[curI][0] = gpioPin;
-		FAKEPWMLIST[curI][1] = curI;	
-		neo_pwm_counting++; //Just to set the later indexes and check if the current count is above max
+	//Create the missing channels and ready the complement before the manager can use them
+	for(i = 0; i < n; i++) {
+		if(i < channels) ind = (__neo_pwm_find(pins[i]) >= 0) ? NEO_OK : __neo_pwm_channel(pins[i], 0, period);
+		else {
+			ind = neo_gpio_pin_mode(pins[i], OUTPUT);
+			if(ind == NEO_OK) ind = neo_gpio_digital_write(pins[i], LOW);
+		}
+
+		if(ind < 0) {
+			pthread_mutex_unlock(&neo_pwm_lock);
+			return ind;
+		}
+	}
+
+	//Everyone lines up on the same grid, far enough ahead for the faster channels to make the first period
+	uint64_t epoch = __neo_pwm_now() + PWMSLICENS;
+	unsigned int gen = ++neo_pwm_gen;
+
+	for(i = 0; i < channels; i++) {
+		params_t *sets = &threadProps[__neo_pwm_find(pins[i])];
+
+		//Keep the duty cycle and polarity of the channel on the new period
+		sets->set.high = __neo_fake_pwm_high(sets->duty, period, sets->inverted);
+		sets->set.low = period - sets->set.high;
+		sets->set.partner = (mode == NEO_PWM_COMPLEMENTARY) ? pins[1] : -1;
+		sets->set.dead = dead;
+		sets->set.epoch = epoch;
+		sets->set.phase = (mode == NEO_PWM_STAGGERED) ? (uint64_t) period * 1000ULL * i / n : 0;
+		sets->set.gen = gen;
+		__neo_pwm_publish(sets);
 	}
-	return NEO_OK; //Return NEO_OK on completion of write
+
+	pthread_mutex_unlock(&neo_pwm_lock);
+	return NEO_OK;
+}
+
+/**
+ * @brief Gets how well a fake pwm channel keeps it's timing
+ * 
+ * The thread manager measures every period from when it's toggles really happened. This gives
+ * the average frequency and duty cycle over the periods since the last reset, how far the duty cycle
+ * is from the one requested and how far the toggles landed from their deadlines (early or late).
+ * It never blocks and doesn't make a syscall
+ * 
+ * @param gpioPin The gpio bank pin of the channel
+ * @param stats Where to store the measurements
+ * @param reset 1 to start the measurements over after reading them
+ * 
+ * @return NEO_OK, NEO_READ_ERROR if no full period was measured yet or NEO_PIN_ERROR if there's no channel on the pin
+ */
+int neo_fake_pwm_stats(int gpioPin, neo_pwm_stats_t *stats, int reset) {
+	uint64_t periods, period_sum, high_sum, req_period_sum, req_high_sum, toggles, jitter_sum, jitter_max;
+	params_t *sets = NULL;
+	unsigned int seq;
+	int i;
+
+	if(stats == NULL) return NEO_FAIL;
+
+	pthread_mutex_lock(&neo_pwm_lock);
+	for(i = 0; i < neo_pwm_counting; i++) {
+		if(FAKEPWMLIST[i][0] == gpioPin) sets = &threadProps[i];
+	}
+	pthread_mutex_unlock(&neo_pwm_lock);
+	if(sets == NULL) return NEO_PIN_ERROR;
+
+	do { //Retry until the copy didn't overlap a publish
+		seq = __atomic_load_n(&sets->stat_seq, __ATOMIC_ACQUIRE);
+		periods = __atomic_load_n(&sets->pub_periods, __ATOMIC_RELAXED);
+		period_sum = __atomic_load_n(&sets->pub_period_sum, __ATOMIC_RELAXED);
+		high_sum = __atomic_load_n(&sets->pub_high_sum, __ATOMIC_RELAXED);
+		req_period_sum = __atomic_load_n(&sets->pub_req_period_sum, __ATOMIC_RELAXED);
+		req_high_sum = __atomic_load_n(&sets->pub_req_high_sum, __ATOMIC_RELAXED);
+		toggles = __atomic_load_n(&sets->pub_toggles, __ATOMIC_RELAXED);
+		jitter_sum = __atomic_load_n(&sets->pub_jitter_sum, __ATOMIC_RELAXED);
+		jitter_max = __atomic_load_n(&sets->pub_jitter_max, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	} while((seq & 1) || seq != __atomic_load_n(&sets->stat_seq, __ATOMIC_RELAXED));
+
+	if(reset) __atomic_store_n(&sets->reset, 1, __ATOMIC_RELEASE);
+	if(periods == 0 || period_sum == 0) return NEO_READ_ERROR;
+
+	stats->periods = periods;
+	stats->freq_hz = (double) periods * 1000000000.0 / (double) period_sum;
+	stats->duty = (double) high_sum / (double) period_sum;
+	stats->duty_error = stats->duty - ((req_period_sum > 0) ? (double) req_high_sum / (double) req_period_sum : 0.0);
+	stats->jitter_max_ns = jitter_max;
+	stats->jitter_avg_ns = (toggles > 0) ? jitter_sum / toggles : 0;
+	stats->realtime = neo_pwm_realtime;
+	return NEO_OK;
 }
 
 /**
  * @brief Duty write method for fake_pwm
  * 
- * This will just write the update duty cycle for the pwm_pin, this will not update the period
- * Unless the global variable is also updated, please make sure that all pins work on same frequency
- * For simplicity reasons. @see neo_fake_pwm_write_period to update the period
+ * This will just write the update duty cycle for the pwm_pin, the channel keeps it's own period
+ * and polarity. A new channel starts on the default period (FAKEPWMPERIOD, 2040us or ~490Hz)
+ * @see neo_fake_pwm_set_period or neo_fake_pwm_write_period to update the period
  * 
  * @param gpioPin The gpio bank pin to set or update the fake pwm manager on
  * @param duty The duty cycle percentage between 0 and 255 (Like arduino)
  * 
- * @return NEO_OK/NEO_DUTY_ERROR or NEO_PIN_ERROR if the params are wrong
+ * @return NEO_OK/NEO_DUTY_ERROR or NEO_PIN_ERROR if the params are wrong, NEO_EXPORT_ERROR when all MAXFAKEPWM channels are used
  */
 int neo_fake_pwm_write(int gpioPin, int duty) {
-	return neo_fake_pwm_write_period(gpioPin, neo_pwm_period, duty); //Run above method with globally set period
+	int ret;
+
+	if(gpioPin < 0 || gpioPin >= GPIOPORTSL) return NEO_PIN_ERROR;
+	if(duty < 0 || duty > 255) return NEO_DUTY_ERROR;
+
+	pthread_mutex_lock(&neo_pwm_lock);
+	ret = __neo_fake_pwm_update(gpioPin, 0, duty, -1); //Keep the period of the channel
+	pthread_mutex_unlock(&neo_pwm_lock);
+	return ret;
 }
 
 /**
@@ -439,26 +1117,22 @@ int neo_fake_pwm_write(int gpioPin, int duty) {
  * @note NEO_UNUSABLE_ERROR might be returned if that pin doesn't support PWM or it's not mapped using device tree editor 
  */
 int neo_pwm_write(int pin, int duty) {
-	if(pin < 0 || pin > PWMPORTSL) return NEO_PIN_ERROR;
+	int ret;
+
+	if(pin < 0 || pin >= PWMPORTSL) return NEO_PIN_ERROR;
 	if(duty < 0 || duty > 255) return NEO_DUTY_ERROR; 
 
-	FILE *curD = pwmD[pin];
-	FILE *curE = pwmE[pin];
-
-	if(curD == NULL || curE == NULL || !USABLEPWM[pin]) return NEO_UNUSABLE_ERROR;
-
-	if(duty == 0) {
-		fprintf(curE, "%d", 0); //Disable pwm
-		fflush(curE);
-	} else {
-		int remap = (int) neo_re_map((float)duty, 0.0f, 255.0f, 0.0f,(float)neo_pwm_period); 
-		fprintf(curE, "%d", 1);
-		fflush(curE);
-		
-		fprintf(curD, "%d", remap);
-		fflush(curD);
+	pthread_mutex_lock(&neo_pwm_real_lock);
+	if(!USABLEPWM[pin]) {
+		pthread_mutex_unlock(&neo_pwm_real_lock);
+		return NEO_UNUSABLE_ERROR;
 	}
-	return NEO_OK;
+
+	neo_pwm_duty_set[pin] = duty;
+	ret = __neo_pwm_update(pin);
+
+	pthread_mutex_unlock(&neo_pwm_real_lock);
+	return ret;
 }
 
 
@@ -467,6 +1141,7 @@ int neo_pwm_write(int pin, int duty) {
  * 
  * Updates the period for all the real pwm pins in one function of course you could do it manually
  * With a for loop. This is just for those lazy people who don't want to do that
+ * Each pin keeps it's duty cycle and polarity
  * 
  * @param period The nanosecond update period per loop period
  * 
@@ -494,6 +1169,9 @@ int neo_pwm_set_period_all(int period) {
 /**
  * @brief Sets period for a single pwm pin
  * 
+ * Every pin runs on it's own period, only this one changes (a 50Hz servo and a 20KHz motor driver can run
+ * at the same time). The pin keeps it's duty cycle and polarity on the new period
+ * 
  * @param pin The pwm pin to set the current
  * @param period The nanosecond update period per loop period
  * 
@@ -501,20 +1179,56 @@ int neo_pwm_set_period_all(int period) {
  * @note The period argument is in nano second update time for period so 1000000000 would be 1Hz (Aka 1 loop per second)
  */
 int neo_pwm_set_period(int pin, int period) {
+	int ret;
+
 	//Safety check for the pin and the period before continuing
-	if(pin < 0 || pin > PWMPORTSL) return NEO_PIN_ERROR;
-	if(period < 0 || period > 1000000000) return NEO_PERIOD_ERROR; 
+	if(pin < 0 || pin >= PWMPORTSL) return NEO_PIN_ERROR;
+	if(period <= 0 || period > 1000000000) return NEO_PERIOD_ERROR; 
 
+	pthread_mutex_lock(&neo_pwm_real_lock);
+	if(!USABLEPWM[pin]) {
+		pthread_mutex_unlock(&neo_pwm_real_lock);
+		return NEO_UNUSABLE_ERROR;
+	}
 
-	//Open sysfs period and write the updated period
-	FILE *curP = pwmP[pin];
-	
-	if(curP == NULL || !USABLEPWM[pin]) return NEO_UNUSABLE_ERROR;
+	//Only this pin changes, it keeps it's duty cycle on the new period
+	neo_pwm_period_set[pin] = period;
+	ret = __neo_pwm_update(pin);
 
-	neo_pwm_period = period;
-	fprintf(curP, "%d", period);
-	fflush(curP);
-	return NEO_OK;	
+	pthread_mutex_unlock(&neo_pwm_real_lock);
+	return ret;	
+}
+
+/**
+ * @brief Sets the polarity of a single pwm pin
+ * 
+ * An inverted pin is low for the duty cycle and high for the rest of the period, so 0 holds the pin high
+ * and 255 holds it low. The controller inverts it when the kernel offers a polarity file for the pwm,
+ * otherwise the duty cycle written to the controller is flipped instead
+ * 
+ * @param pin The pwm pin to set the polarity of
+ * @param inverted 1 for an active low pin, 0 for the normal active high one
+ * 
+ * @return NEO_OK/NEO_PIN_ERROR or NEO_UNUSABLE_ERROR if the params are wrong
+ * @note The kernel only takes a new polarity while the pwm is disabled, so the pin drops out for a moment when it changes
+ */
+int neo_pwm_set_polarity(int pin, int inverted) {
+	int ret;
+
+	if(pin < 0 || pin >= PWMPORTSL) return NEO_PIN_ERROR;
+
+	pthread_mutex_lock(&neo_pwm_real_lock);
+	if(!USABLEPWM[pin]) {
+		pthread_mutex_unlock(&neo_pwm_real_lock);
+		return NEO_UNUSABLE_ERROR;
+	}
+
+	neo_pwm_inverted[pin] = (inverted) ? 1 : 0;
+	ret = __neo_pwm_polarity(pin, neo_pwm_inverted[pin]);
+	if(ret == NEO_OK) ret = __neo_pwm_update(pin);
+
+	pthread_mutex_unlock(&neo_pwm_real_lock);
+	return ret;	
 }
 
 /**
@@ -531,30 +1245,22 @@ int neo_pwm_free()
 	int i;
 
 	fail = NEO_OK;
+	__neo_ramp_free(NEO_RAMP_PWM); //Before the lock, the ramp thread takes it to write the pins
 	
+	pthread_mutex_lock(&neo_pwm_real_lock);
 	if(neo_pwm_freed == 0) {
 		//Loop through each pinSet
 		for(i = 0; i < PWMPORTSL; i++) {
 			if(USABLEPWM[i]) {
-				FILE *curP = pwmP[i];
-				FILE *curD = pwmD[i];
-				FILE *curE = pwmE[i];
-	
-		
 				//Close all three sysfs files
 				//The Period, Duty and the Enable
-				if(curP != NULL) fclose(curP);
-				else fail = NEO_UNUSABLE_ERROR;
-	
-				if(curD != NULL) fclose(curD);
-				else fail = NEO_UNUSABLE_ERROR;
-	
-				if(curE != NULL) fclose(curE);
-				else fail = NEO_UNUSABLE_ERROR;
+				if(pwmP[i] < 0 || pwmD[i] < 0 || pwmE[i] < 0) fail = NEO_UNUSABLE_ERROR;
+				__neo_pwm_close(i);
 			}
 		}
 		neo_pwm_freed = 2;
 	}
+	pthread_mutex_unlock(&neo_pwm_real_lock);
 	return fail;
 }
 
@@ -655,7 +1361,8 @@ int neo_pwm_free()
  * 
  * Unlike the Real PWM this isn't as precise since it uses the processor clock and not a custom resolution clock
  * This also is down to the speed of sysfs. I was able to do up to 100KHz (About half the period time of an arduino(p.s. that's good))
- * On about 30 pins, before the the led seemed to jitter at a visible amount. So I would recommend to leave it at 49KHz if using FakePWM
+ * On about 30 pins, before the the led seemed to jitter at a visible amount. The fake pwm periods are in micro seconds and a channel
+ * starts at 2040us (~490Hz like an arduino), I would recommend to stay around there if using FakePWM
  * on a lot of the pins. This is a lot easier to use than the Real PWM because it has the same mapping as the gpio since it uses the same
  * methods in the backend. Try the example below for pin 13 which is the led.
  *
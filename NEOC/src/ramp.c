@@ -0,0 +1,362 @@
+/*----------------------------------------------------------------------||
+|                                                                        |
+| Copyright (C) 2016 by David Smerkous                                   |
+| License Date: 11/27/2016                                               |
+| Modifiers: none                                                        |
+|                                                                        |
+| NEOC (libneo) is free software: you can redistribute it and/or modify  |
+|   it under the terms of the GNU General Public License as published by |
+|   the Free Software Foundation, either version 3 of the License, or    |
+|   (at your option) any later version.                                  |
+|                                                                        |
+| NEOC (libneo) is distributed in the hope that it will be useful,       |
+|   but WITHOUT ANY WARRANTY; without even the implied warranty of       |
+|   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        |
+|   GNU General Public License for more details.                         |
+|                                                                        |
+| You should have received a copy of the GNU General Public License      |
+|   along with this program.  If not, see http://www.gnu.org/licenses/   |
+|                                                                        |
+||----------------------------------------------------------------------*/
+
+/**
+ * 
+ * @file ramp.c
+ * @author David Smerkous
+ * @date 11/28/2016
+ * @brief Fades real and fake pwm channels in the background
+ *
+ * @details A ramp moves a channel from it's current duty cycle to a target over a duration along
+ * a curve. Every ramp is run by one thread that wakes up on a fixed tick, works out the duty of each
+ * channel from lookup tables made once (no floating point on the tick) and only writes the channels
+ * whose duty changed. So a fade costs a table lookup per tick instead of a thread and a sleep loop per led
+ * 
+ * @note The gamma curve fades in perceived brightness, the eyes see a linear duty cycle jump at the bottom and crawl at the top
+ */
+
+#include <neo.h>
+
+#ifndef DOXYGEN_SKIP
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+
+struct ramp_h {
+	int active;
+	int from, to; //Duty cycles (0 - 255)
+	int curve;
+	uint64_t start, duration; //CLOCK_MONOTONIC (ns)
+	int last; //The duty last written
+	unsigned int gen; //Bumped for every new ramp on the channel
+};
+
+//Declare alias for struct
+typedef struct ramp_h ramp_t;
+
+//Real pwm pins first then the gpio pins of the fake pwm
+ramp_t neo_ramps[RAMPSLOTSL];
+int neo_ramp_active = 0; //How many ramps are running
+
+//The easing curves, the progress of the ramp (0 - RAMPLUTL) to how far along the duty is (0 - 65536)
+uint32_t neo_ramp_ease[NEO_RAMP_EASE_IN_OUT + 1][RAMPLUTL + 1];
+
+//Perceived brightness (0 - RAMPLUTL) to duty cycle (8.8 fixed point) and duty cycle back to the brightness
+uint32_t neo_ramp_gamma[RAMPLUTL + 1];
+int neo_ramp_degamma[256];
+
+pthread_once_t neo_ramp_tables = PTHREAD_ONCE_INIT;
+pthread_mutex_t neo_ramp_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t neo_ramp_life = PTHREAD_MUTEX_INITIALIZER; //Starting and stopping the thread, taken before neo_ramp_lock
+pthread_cond_t neo_ramp_wake = PTHREAD_COND_INITIALIZER;
+pthread_t neo_ramp_thread;
+int neo_ramp_running = 0;
+int neo_ramp_quit = 0;
+
+//Current CLOCK_MONOTONIC time in nanoseconds
+uint64_t __neo_ramp_now() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+//Fifth root of 0 - 1 by newton's method, all gamma 2.2 needs without libm
+double __neo_ramp_root5(double x) {
+	double y = 1.0;
+	int i;
+
+	if(x <= 0.0) return 0.0;
+	for(i = 0; i < 40; i++) y = (4.0 * y + x / (y * y * y * y)) / 5.0;
+	return y;
+}
+
+//Fills every lookup table, only runs once
+void __neo_ramp_build() {
+	int i, d, lo;
+
+	for(i = 0; i <= RAMPLUTL; i++) {
+		double p = (double) i / RAMPLUTL;
+
+		neo_ramp_ease[NEO_RAMP_LINEAR][i] = (uint32_t) (p * 65536.0 + 0.5);
+		neo_ramp_ease[NEO_RAMP_GAMMA][i] = neo_ramp_ease[NEO_RAMP_LINEAR][i]; //Linear in brightness
+		neo_ramp_ease[NEO_RAMP_EASE_IN][i] = (uint32_t) (p * p * 65536.0 + 0.5);
+		neo_ramp_ease[NEO_RAMP_EASE_OUT][i] = (uint32_t) ((1.0 - (1.0 - p) * (1.0 - p)) * 65536.0 + 0.5);
+		neo_ramp_ease[NEO_RAMP_EASE_IN_OUT][i] = (uint32_t) (p * p * (3.0 - 2.0 * p) * 65536.0 + 0.5);
+
+		//p^2.2 = p^2 * p^(1/5)
+		neo_ramp_gamma[i] = (uint32_t) (p * p * __neo_ramp_root5(p) * 255.0 * 256.0 + 0.5);
+	}
+
+	//The brightness of a duty cycle is the closest entry of the gamma table
+	for(d = 0, lo = 0; d < 256; d++) {
+		uint32_t want = (uint32_t) d * 256;
+
+		while(lo < RAMPLUTL && neo_ramp_gamma[lo + 1] <= want) lo++;
+		neo_ramp_degamma[d] = (lo < RAMPLUTL && neo_ramp_gamma[lo + 1] - want < want - neo_ramp_gamma[lo]) ? lo + 1 : lo;
+	}
+}
+
+//The duty cycle of a ramp at a time
+int __neo_ramp_duty(ramp_t *r, uint64_t now) {
+	uint64_t elapsed = now - r->start;
+	int p;
+
+	if(now < r->start) return r->from;
+	if(elapsed >= r->duration) return r->to;
+	p = (int) (elapsed * RAMPLUTL / r->duration);
+
+	if(r->curve == NEO_RAMP_GAMMA) {
+		int lf = neo_ramp_degamma[r->from], lt = neo_ramp_degamma[r->to];
+		return (int) ((neo_ramp_gamma[lf + (lt - lf) * p / RAMPLUTL] + 128) >> 8);
+	}
+	return r->from + (int) (((int64_t) (r->to - r->from) * neo_ramp_ease[r->curve][p] + 32768) >> 16);
+}
+
+//Writes a duty cycle to the channel of a slot
+int __neo_ramp_write(int slot, int duty) {
+	if(slot < PWMPORTSL) return neo_pwm_write(slot, duty);
+	return neo_fake_pwm_write(slot - PWMPORTSL, duty);
+}
+
+//The ramp thread, ticks while there are ramps and sleeps on the condition otherwise
+void *__neo_ramp_loop(void *arg) {
+	int slots[RAMPSLOTSL], duties[RAMPSLOTSL], done[RAMPSLOTSL];
+	unsigned int gens[RAMPSLOTSL];
+	uint64_t tick = __neo_ramp_now();
+	(void) arg;
+
+	pthread_mutex_lock(&neo_ramp_lock);
+	while(!neo_ramp_quit) {
+		int i, n = 0;
+
+		if(neo_ramp_active == 0) {
+			pthread_cond_wait(&neo_ramp_wake, &neo_ramp_lock);
+			tick = __neo_ramp_now();
+			continue;
+		}
+
+		//Work out every duty that changed, the lock is let go between the writes so submitters aren't held up
+		for(i = 0; i < RAMPSLOTSL; i++) {
+			ramp_t *r = &neo_ramps[i];
+			int duty;
+
+			if(!r->active) continue;
+			duty = __neo_ramp_duty(r, tick);
+			done[n] = tick >= r->start + r->duration;
+			if(duty == r->last) {
+				if(done[n]) {
+					r->active = 0;
+					neo_ramp_active--;
+				}
+				continue;
+			}
+
+			r->last = duty;
+			slots[n] = i;
+			duties[n] = duty;
+			gens[n] = r->gen;
+			n++;
+		}
+		pthread_mutex_unlock(&neo_ramp_lock);
+
+		for(i = 0; i < n; i++) {
+			ramp_t *r = &neo_ramps[slots[i]];
+
+			//Each write is done under the lock and only if the ramp is still the one the duty came from,
+			//so a stop or a new ramp is never overwritten by a stale duty
+			pthread_mutex_lock(&neo_ramp_lock);
+			if(r->active && r->gen == gens[i]) {
+				//Finished once the target is written, or the channel went away (freed or taken by a group)
+				if(__neo_ramp_write(slots[i], duties[i]) != NEO_OK || done[i]) {
+					r->active = 0;
+					neo_ramp_active--;
+				}
+			}
+			pthread_mutex_unlock(&neo_ramp_lock);
+		}
+
+		//Absolute ticks so the ramps don't drift with the time the writes took
+		tick += RAMPTICKNS;
+		uint64_t now = __neo_ramp_now();
+		if(tick < now) tick = now;
+		struct timespec ts = { .tv_sec = tick / 1000000000ULL, .tv_nsec = tick % 1000000000ULL };
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+
+		pthread_mutex_lock(&neo_ramp_lock);
+	}
+	pthread_mutex_unlock(&neo_ramp_lock);
+	return NULL;
+}
+
+//The slot of a channel, -1 if the channel is wrong
+int __neo_ramp_slot(int type, int pin) {
+	if(type == NEO_RAMP_PWM) return (pin >= 0 && pin < PWMPORTSL) ? pin : -1;
+	if(type == NEO_RAMP_FAKE_PWM) return (pin >= 0 && pin < GPIOPORTSL) ? PWMPORTSL + pin : -1;
+	return -1;
+}
+
+//Drops the ramps of one type of channel, the thread is stopped once there are none left
+//(neo_gpio_free drops the fake pwm ones and neo_pwm_free the real ones)
+void __neo_ramp_free(int type) {
+	int i, first = (type == NEO_RAMP_PWM) ? 0 : PWMPORTSL, last = (type == NEO_RAMP_PWM) ? PWMPORTSL : RAMPSLOTSL;
+
+	pthread_mutex_lock(&neo_ramp_life);
+	pthread_mutex_lock(&neo_ramp_lock);
+	for(i = first; i < last; i++) {
+		if(neo_ramps[i].active) neo_ramp_active--;
+		neo_ramps[i].active = 0;
+		neo_ramps[i].gen++;
+	}
+
+	if(neo_ramp_running && neo_ramp_active == 0) {
+		neo_ramp_quit = 1;
+		pthread_cond_signal(&neo_ramp_wake);
+		pthread_mutex_unlock(&neo_ramp_lock);
+		pthread_join(neo_ramp_thread, NULL); //Nothing can start a ramp while neo_ramp_life is held
+		pthread_mutex_lock(&neo_ramp_lock);
+		neo_ramp_running = 0;
+		neo_ramp_quit = 0;
+	}
+	pthread_mutex_unlock(&neo_ramp_lock);
+	pthread_mutex_unlock(&neo_ramp_life);
+}
+
+#endif
+
+/**
+ * @brief Fades a real or fake pwm channel to a duty cycle in the background
+ * 
+ * The channel goes from the duty cycle it's at to the target over the duration along the curve,
+ * a new ramp on a channel that's still ramping starts from where that one got to. One thread runs every
+ * ramp on a RAMPTICKNS tick and only writes the channels whose duty cycle changed, it's started by the first ramp.
+ * NEO_RAMP_LINEAR moves the duty cycle evenly, NEO_RAMP_GAMMA moves the perceived brightness evenly (gamma 2.2)
+ * and NEO_RAMP_EASE_IN, NEO_RAMP_EASE_OUT and NEO_RAMP_EASE_IN_OUT start slow, end slow or both.
+ * This returns right away @see neo_pwm_ramp_busy()
+ * 
+ * @param type NEO_RAMP_PWM for a real pwm pin (neo_pwm_write()) or NEO_RAMP_FAKE_PWM for a gpio pin (neo_fake_pwm_write())
+ * @param pin The real pwm pin or the gpio bank pin of the channel
+ * @param target The duty cycle to end on between 0 and 255
+ * @param duration_ns How long the fade takes in nanoseconds (0 writes the target right away)
+ * @param curve NEO_RAMP_LINEAR, NEO_RAMP_GAMMA, NEO_RAMP_EASE_IN, NEO_RAMP_EASE_OUT or NEO_RAMP_EASE_IN_OUT
+ * 
+ * @return NEO_OK, NEO_PIN_ERROR if the pin or type are wrong, NEO_DUTY_ERROR for a wrong target, NEO_FAIL for a wrong curve
+ * or the error of writing the channel (@see neo_pwm_write() and neo_fake_pwm_write())
+ * 
+ * @note A fake pwm pin without a channel gets one starting at 0 duty, the channel keeps it's period and polarity
+ * @note neo_pwm_free() drops the ramps of the real pwm pins and neo_gpio_free() the ones of the fake pwm pins
+ * @note Writing a ramping channel directly races the ramp, stop it first @see neo_pwm_ramp_stop()
+ */
+int neo_pwm_ramp(int type, int pin, int target, uint64_t duration_ns, int curve) {
+	int slot = __neo_ramp_slot(type, pin), from, ret;
+	ramp_t *r;
+
+	if(slot < 0) return NEO_PIN_ERROR;
+	if(target < 0 || target > 255) return NEO_DUTY_ERROR;
+	if(curve < NEO_RAMP_LINEAR || curve > NEO_RAMP_EASE_IN_OUT) return NEO_FAIL;
+
+	pthread_once(&neo_ramp_tables, __neo_ramp_build);
+
+	pthread_mutex_lock(&neo_ramp_life);
+	pthread_mutex_lock(&neo_ramp_lock);
+	r = &neo_ramps[slot];
+
+	//Start from where the channel is, writing it makes sure it can be written (and gives a fake pwm pin it's channel)
+	from = (r->active) ? r->last : ((type == NEO_RAMP_PWM) ? __neo_pwm_duty(pin) : __neo_fake_pwm_duty(pin));
+	ret = (from < 0) ? from : __neo_ramp_write(slot, (duration_ns == 0) ? target : from);
+	if(ret != NEO_OK || duration_ns == 0) {
+		if(r->active) neo_ramp_active--;
+		r->active = 0;
+		r->gen++;
+		pthread_mutex_unlock(&neo_ramp_lock);
+		pthread_mutex_unlock(&neo_ramp_life);
+		return ret;
+	}
+
+	if(!neo_ramp_running) {
+		if(pthread_create(&neo_ramp_thread, NULL, __neo_ramp_loop, NULL) != 0) {
+			pthread_mutex_unlock(&neo_ramp_lock);
+			pthread_mutex_unlock(&neo_ramp_life);
+			return NEO_FAIL;
+		}
+		neo_ramp_running = 1;
+	}
+
+	if(!r->active) neo_ramp_active++;
+	r->active = 1;
+	r->from = r->last = from;
+	r->to = target;
+	r->curve = curve;
+	r->start = __neo_ramp_now();
+	r->duration = duration_ns;
+	r->gen++;
+
+	pthread_cond_signal(&neo_ramp_wake);
+	pthread_mutex_unlock(&neo_ramp_lock);
+	pthread_mutex_unlock(&neo_ramp_life);
+	return NEO_OK;
+}
+
+/**
+ * @brief Stops the ramp of a channel where it is
+ * 
+ * @param type NEO_RAMP_PWM or NEO_RAMP_FAKE_PWM @see neo_pwm_ramp()
+ * @param pin The real pwm pin or the gpio bank pin of the channel
+ * 
+ * @return NEO_OK or NEO_PIN_ERROR if the pin or type are wrong
+ * @note The channel keeps the last duty cycle the ramp wrote, nothing is written by the ramp after this returns
+ */
+int neo_pwm_ramp_stop(int type, int pin) {
+	int slot = __neo_ramp_slot(type, pin);
+
+	if(slot < 0) return NEO_PIN_ERROR;
+
+	pthread_mutex_lock(&neo_ramp_lock);
+	if(neo_ramps[slot].active) {
+		neo_ramps[slot].active = 0;
+		neo_ramp_active--;
+	}
+	neo_ramps[slot].gen++;
+	pthread_mutex_unlock(&neo_ramp_lock);
+	return NEO_OK;
+}
+
+/**
+ * @brief Checks if a channel is still ramping
+ * 
+ * @param type NEO_RAMP_PWM or NEO_RAMP_FAKE_PWM @see neo_pwm_ramp()
+ * @param pin The real pwm pin or the gpio bank pin of the channel
+ * 
+ * @return 1 while the ramp is running, 0 once it's done or stopped or NEO_PIN_ERROR if the pin or type are wrong
+ */
+int neo_pwm_ramp_busy(int type, int pin) {
+	int slot = __neo_ramp_slot(type, pin), busy;
+
+	if(slot < 0) return NEO_PIN_ERROR;
+
+	pthread_mutex_lock(&neo_ramp_lock);
+	busy = neo_ramps[slot].active;
+	pthread_mutex_unlock(&neo_ramp_lock);
+	return busy;
+}
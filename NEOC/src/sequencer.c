@@ -0,0 +1,220 @@
+/*----------------------------------------------------------------------||
+|                                                                        |
+| Copyright (C) 2016 by David Smerkous                                   |
+| License Date: 11/27/2016                                               |
+| Modifiers: none                                                        |
+|                                                                        |
+| NEOC (libneo) is free software: you can redistribute it and/or modify  |
+|   it under the terms of the GNU General Public License as published by |
+|   the Free Software Foundation, either version 3 of the License, or    |
+|   (at your option) any later version.                                  |
+|                                                                        |
+| NEOC (libneo) is distributed in the hope that it will be useful,       |
+|   but WITHOUT ANY WARRANTY; without even the implied warranty of       |
+|   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        |
+|   GNU General Public License for more details.                         |
+|                                                                        |
+| You should have received a copy of the GNU General Public License      |
+|   along with this program.  If not, see http://www.gnu.org/licenses/   |
+|                                                                        |
+||----------------------------------------------------------------------*/
+
+/**
+ * 
+ * @file sequencer.c
+ * @author David Smerkous
+ * @date 11/28/2016
+ * @brief Hard real time playback of precomputed gpio waveforms
+ *
+ * @details A waveform is an array of steps {t_ns, mask, values}, each one writes the pins in mask
+ * to values at t_ns after the start (@see neo_gpio_write_mask()). The steps are played by a single
+ * SCHED_FIFO thread that sleeps to absolute CLOCK_MONOTONIC deadlines and can busy wait the last
+ * few microseconds, so the steps don't drift and the jitter is the wake up latency of the kernel
+ * 
+ * @note Use the NEO_GPIO_MMAP backend, a register write is a fraction of a microsecond where sysfs is tens
+ * @note SCHED_FIFO needs root (or CAP_SYS_NICE), without it the thread still runs at normal priority
+ */
+
+#include <neo.h>
+
+#ifndef DOXYGEN_SKIP
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+
+//The waveform being played, it belongs to the user and must stay valid until it's done
+const neo_seq_step_t *neo_seq_steps = NULL;
+int neo_seq_count = 0;
+uint64_t neo_seq_spin = 0; //How long to busy wait before each deadline (ns)
+int64_t *neo_seq_late = NULL; //Optional lateness of every step
+
+pthread_t neo_seq_thread;
+int neo_seq_active = 0; //If the thread was started and not joined yet
+int neo_seq_abort = 0; //Set by neo_seq_stop
+neo_seq_stats_t neo_seq_result;
+
+//Current CLOCK_MONOTONIC time in nanoseconds
+uint64_t __neo_seq_now() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+//Sleeps until the absolute deadline, in slices so a stop doesn't wait on a long gap
+int __neo_seq_sleep(uint64_t deadline) {
+	struct timespec ts;
+	uint64_t now = __neo_seq_now();
+
+	while(now < deadline) {
+		if(__atomic_load_n(&neo_seq_abort, __ATOMIC_RELAXED)) return NEO_FAIL;
+
+		uint64_t until = (deadline - now > SEQSLICENS) ? now + SEQSLICENS : deadline;
+		ts.tv_sec = until / 1000000000ULL;
+		ts.tv_nsec = until % 1000000000ULL;
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL); //EINTR just loops
+		now = __neo_seq_now();
+	}
+	return NEO_OK;
+}
+
+//The sequencer thread, plays every step against the start time
+void *__neo_seq_loop(void *arg) {
+	neo_seq_stats_t *st = &neo_seq_result;
+	uint64_t start, deadline, now, total = 0;
+	int ind;
+	(void) arg;
+
+	start = __neo_seq_now() + SEQLEADNS; //Give the first step the same lead as the others
+	st->start_ns = start;
+
+	for(ind = 0; ind < neo_seq_count; ind++) {
+		const neo_seq_step_t *step = &neo_seq_steps[ind];
+		deadline = start + step->t_ns;
+
+		//Sleep up to the spin window then burn the rest of it
+		if(deadline > neo_seq_spin && __neo_seq_sleep(deadline - neo_seq_spin) != NEO_OK) break;
+		if(__atomic_load_n(&neo_seq_abort, __ATOMIC_RELAXED)) break;
+		while(__neo_seq_now() < deadline);
+
+		st->error = neo_gpio_write_mask(step->mask, step->values);
+		if(st->error != NEO_OK) break; //The rest of the waveform would be played from a wrong state
+		now = __neo_seq_now();
+
+		//The lateness is when the write was done, that's when the pins changed
+		int64_t late = (int64_t) (now - deadline);
+		if(neo_seq_late != NULL) neo_seq_late[ind] = late;
+
+		if(st->steps == 0 || late < st->late_min_ns) st->late_min_ns = late;
+		if(st->steps == 0 || late > st->late_max_ns) st->late_max_ns = late;
+		if(late > SEQLATENS) st->late_over++;
+		total += late;
+		st->steps++;
+	}
+
+	if(st->steps > 0) st->late_avg_ns = (int64_t) total / (int64_t) st->steps;
+	return NULL;
+}
+
+#endif
+
+/**
+ * @brief Starts playing a gpio waveform
+ * 
+ * Every step writes the pins in it's mask to it's values (bit n is gpio pin n) at t_ns after the
+ * start. The steps are played in order by a SCHED_FIFO thread sleeping to absolute deadlines.
+ * With spin_ns the thread wakes up that much early and busy waits the rest, trading a core for
+ * less jitter (around 50000 is a good start). This returns right away @see neo_seq_wait()
+ * 
+ * @return NEO_OK, NEO_FAIL if a waveform is already playing or the steps aren't in order, 
+ * NEO_PIN_ERROR/NEO_DIR_ERROR/NEO_UNUSABLE_ERROR if a pin can't be written (nothing is played then)
+ * @param steps The steps ordered by t_ns, must stay valid until the waveform is done
+ * @param count The amount of steps
+ * @param spin_ns How long to busy wait before each step in nanoseconds (0 to only sleep, at most SEQMAXSPINNS)
+ * @param lateness Where to store how late every step was in nanoseconds (can be NULL, otherwise count long)
+ *
+ * @note Every pin used must be set to OUTPUT first
+ * @note A write that fails during the playback stops the waveform, neo_seq_wait() gives back the error and the step
+ * @warning The busy wait runs at SCHED_FIFO priority 80, steps closer together than spin_ns keep the core busy the whole
+ * time. On a single core nothing below that priority (the kernel's threads included) runs until the waveform is done,
+ * so keep the spin short or use 0 there
+ */
+int neo_seq_start(const neo_seq_step_t *steps, int count, uint64_t spin_ns, int64_t *lateness) {
+	struct sched_param param;
+	pthread_attr_t attr;
+	uint64_t used = 0;
+	int ind, pin, ret;
+
+	if(neo_seq_active) return NEO_FAIL;
+	if(steps == NULL || count < 1) return NEO_FAIL;
+
+	//Check everything first so a bad step can't stop the waveform half way
+	for(ind = 0; ind < count; ind++) {
+		if(ind > 0 && steps[ind].t_ns < steps[ind - 1].t_ns) return NEO_FAIL;
+		if(steps[ind].mask >> GPIOPORTSL) return NEO_PIN_ERROR;
+		used |= steps[ind].mask;
+	}
+	for(pin = 0; pin < GPIOPORTSL; pin++) {
+		if(!((used >> pin) & 1ULL)) continue;
+		if(__neo_gpio_ready(pin) != NEO_OK) return NEO_UNUSABLE_ERROR;
+		if(GPIOGET(DIRGPIO, pin) != (unsigned char) OUTPUT) return NEO_DIR_ERROR;
+	}
+
+	neo_seq_steps = steps;
+	neo_seq_count = count;
+	neo_seq_spin = (spin_ns > SEQMAXSPINNS) ? SEQMAXSPINNS : spin_ns;
+	neo_seq_late = lateness;
+	neo_seq_abort = 0;
+	memset(&neo_seq_result, 0, sizeof(neo_seq_result));
+
+	//Try real time first, fall back to a normal thread when not allowed
+	pthread_attr_init(&attr);
+	pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+	pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+	param.sched_priority = SEQPRIORITY;
+	pthread_attr_setschedparam(&attr, &param);
+
+	ret = pthread_create(&neo_seq_thread, &attr, __neo_seq_loop, NULL);
+	pthread_attr_destroy(&attr);
+	neo_seq_result.realtime = (ret == 0);
+	if(ret == EPERM) ret = pthread_create(&neo_seq_thread, NULL, __neo_seq_loop, NULL);
+	if(ret != 0) return NEO_FAIL;
+
+	neo_seq_active = 1;
+	return NEO_OK;
+}
+
+/**
+ * @brief Waits for the waveform to be done and gets it's timing
+ * 
+ * @return NEO_OK or NEO_FAIL if no waveform was started
+ * @param stats Where to store the lateness of the steps and the error that stopped them if any (can be NULL)
+ */
+int neo_seq_wait(neo_seq_stats_t *stats) {
+	if(!neo_seq_active) return NEO_FAIL;
+
+	pthread_join(neo_seq_thread, NULL);
+	neo_seq_active = 0;
+
+	if(stats != NULL) *stats = neo_seq_result;
+	return NEO_OK;
+}
+
+/**
+ * @brief Stops the waveform before the next step
+ * 
+ * @return NEO_OK or NEO_FAIL if no waveform was started
+ * @param stats Where to store the lateness of the steps played so far (can be NULL)
+ *
+ * @note The pins stay the way the last played step left them
+ */
+int neo_seq_stop(neo_seq_stats_t *stats) {
+	if(!neo_seq_active) return NEO_FAIL;
+
+	__atomic_store_n(&neo_seq_abort, 1, __ATOMIC_RELAXED);
+	return neo_seq_wait(stats);
+}
@@ -0,0 +1,298 @@
+/*----------------------------------------------------------------------||
+|                                                                        |
+| Copyright (C) 2016 by David Smerkous                                   |
+| License Date: 11/27/2016                                               |
+| Modifiers: none                                                        |
+|                                                                        |
+| NEOC (libneo) is free software: you can redistribute it and/or modify  |
+|   it under the terms of the GNU General Public License as published by |
+|   the Free Software Foundation, either version 3 of the License, or    |
+|   (at your option) any later version.                                  |
+|                                                                        |
+| NEOC (libneo) is distributed in the hope that it will be useful,       |
+|   but WITHOUT ANY WARRANTY; without even the implied warranty of       |
+|   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        |
+|   GNU General Public License for more details.                         |
+|                                                                        |
+| You should have received a copy of the GNU General Public License      |
+|   along with this program.  If not, see http://www.gnu.org/licenses/   |
+|                                                                        |
+||----------------------------------------------------------------------*/
+
+/**
+ * 
+ * @file vcd.c
+ * @author David Smerkous
+ * @date 11/28/2016
+ * @brief Streams the pin activity of libneo to a VCD (value change dump) file
+ *
+ * @details Every pin write (digital writes, masks, fake pwm toggles) and every edge seen by
+ * the interrupt engine of the recorded pins is pushed to a lock-free ring with its timestamp,
+ * that's all the hot path pays. A background thread drains the ring into text and hands full
+ * buffers to a second thread that writes them, so the formatting never waits on the disk.
+ * The file opens in GTKWave or any other VCD viewer with one wire per gpio pin
+ * 
+ * @note Times are CLOCK_MONOTONIC nanoseconds from the start of the recording
+ */
+
+#include <neo.h>
+
+#ifndef DOXYGEN_SKIP
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+
+struct vcd_event_h {
+	uint64_t seq; //Slot turn, tells producers and the drain thread who owns the slot
+	uint64_t ts;
+	int pin;
+	int value;
+};
+
+//Declare alias for struct
+typedef struct vcd_event_h vcd_event_t;
+
+//Many producers (any thread writing a pin and the dispatcher), one consumer (the drain thread)
+vcd_event_t neo_vcd_ring[VCDRINGL];
+uint64_t neo_vcd_head = 0;
+uint64_t neo_vcd_tail = 0;
+uint64_t neo_vcd_dropped = 0;
+
+uint64_t neo_vcd_pins = 0; //The recorded pins, 0 when not recording
+uint64_t neo_vcd_start_ns = 0;
+int neo_vcd_fd = -1;
+int neo_vcd_running = 0;
+
+//Double buffer between the drain thread and the io thread
+char neo_vcd_bufs[2][VCDBUFL];
+size_t neo_vcd_lens[2];
+int neo_vcd_pending = -1; //The buffer the io thread has to write (-1 is none)
+int neo_vcd_quit = 0;
+pthread_mutex_t neo_vcd_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t neo_vcd_ready = PTHREAD_COND_INITIALIZER;
+pthread_cond_t neo_vcd_done = PTHREAD_COND_INITIALIZER;
+pthread_t neo_vcd_drain_thread, neo_vcd_io_thread;
+
+//Current CLOCK_MONOTONIC time in nanoseconds
+uint64_t __neo_vcd_now() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+//Gets a timestamp for a write when anything is being recorded (0 otherwise)
+uint64_t __neo_vcd_stamp() {
+	return (__atomic_load_n(&neo_vcd_pins, __ATOMIC_RELAXED)) ? __neo_vcd_now() : 0;
+}
+
+//Pushes a pin change to the ring when the pin is recorded, a ts of 0 is now
+void __neo_vcd_record(int pin, int value, uint64_t ts) {
+	uint64_t pos, seq;
+	vcd_event_t *ev;
+
+	if(!((__atomic_load_n(&neo_vcd_pins, __ATOMIC_RELAXED) >> pin) & 1ULL)) return;
+	if(ts == 0) ts = __neo_vcd_now();
+
+	//Claim a free slot, a slot is free when its seq is the position asking for it
+	pos = __atomic_load_n(&neo_vcd_head, __ATOMIC_RELAXED);
+	while(1) {
+		ev = &neo_vcd_ring[pos % VCDRINGL];
+		seq = __atomic_load_n(&ev->seq, __ATOMIC_ACQUIRE);
+
+		if(seq == pos) {
+			if(__atomic_compare_exchange_n(&neo_vcd_head, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+		} else if((int64_t) (seq - pos) < 0) { //Still holding an event from the last lap
+			__atomic_add_fetch(&neo_vcd_dropped, 1, __ATOMIC_RELAXED);
+			return;
+		} else pos = __atomic_load_n(&neo_vcd_head, __ATOMIC_RELAXED);
+	}
+
+	ev->ts = ts;
+	ev->pin = pin;
+	ev->value = value;
+	__atomic_store_n(&ev->seq, pos + 1, __ATOMIC_RELEASE); //Hand it to the drain thread
+}
+
+//Hands the filled buffer to the io thread and goes on with the other one
+int __neo_vcd_swap(int cur) {
+	pthread_mutex_lock(&neo_vcd_lock);
+	while(neo_vcd_pending != -1) pthread_cond_wait(&neo_vcd_done, &neo_vcd_lock);
+	neo_vcd_pending = cur;
+	pthread_cond_signal(&neo_vcd_ready);
+	pthread_mutex_unlock(&neo_vcd_lock);
+
+	cur ^= 1;
+	neo_vcd_lens[cur] = 0;
+	return cur;
+}
+
+//The io thread, writes whatever buffer the drain thread hands over
+void *__neo_vcd_io_loop(void *arg) {
+	(void) arg;
+
+	pthread_mutex_lock(&neo_vcd_lock);
+	while(1) {
+		while(neo_vcd_pending == -1 && !neo_vcd_quit) pthread_cond_wait(&neo_vcd_ready, &neo_vcd_lock);
+		if(neo_vcd_pending == -1) break; //Quit with nothing left
+
+		int b = neo_vcd_pending;
+		pthread_mutex_unlock(&neo_vcd_lock);
+
+		size_t off = 0;
+		while(off < neo_vcd_lens[b]) {
+			ssize_t w = write(neo_vcd_fd, neo_vcd_bufs[b] + off, neo_vcd_lens[b] - off);
+			if(w <= 0) break; //Disk full or gone, drop the buffer
+			off += (size_t) w;
+		}
+
+		pthread_mutex_lock(&neo_vcd_lock);
+		neo_vcd_pending = -1;
+		pthread_cond_signal(&neo_vcd_done);
+	}
+	pthread_mutex_unlock(&neo_vcd_lock);
+	return NULL;
+}
+
+//The drain thread, turns the ring into VCD text
+void *__neo_vcd_drain_loop(void *arg) {
+	struct timespec tick = {0, VCDTICKNS};
+	uint64_t tail = 0, last = 0;
+	int cur = 0, stamped = 0;
+	(void) arg;
+
+	neo_vcd_lens[0] = 0;
+	while(1) {
+		int running = __atomic_load_n(&neo_vcd_running, __ATOMIC_ACQUIRE);
+		vcd_event_t *ev = &neo_vcd_ring[tail % VCDRINGL];
+
+		if(__atomic_load_n(&ev->seq, __ATOMIC_ACQUIRE) != tail + 1) {
+			//Nothing queued, write out what we have and wait a tick
+			if(neo_vcd_lens[cur] > 0) cur = __neo_vcd_swap(cur);
+			if(!running) break;
+			nanosleep(&tick, NULL);
+			continue;
+		}
+
+		//Events from different threads can be a bit out of order, time can't go back in a VCD
+		uint64_t t = (ev->ts > neo_vcd_start_ns) ? ev->ts - neo_vcd_start_ns : 0;
+		if(t < last) t = last;
+
+		char *out = neo_vcd_bufs[cur] + neo_vcd_lens[cur];
+		int len = 0;
+		if(!stamped || t != last) len += sprintf(out, "#%llu\n", (unsigned long long) t);
+		len += sprintf(out + len, "%c%c\n", (ev->value) ? '1' : '0', VCDID(ev->pin));
+		neo_vcd_lens[cur] += len;
+		last = t;
+		stamped = 1;
+
+		__atomic_store_n(&ev->seq, tail + VCDRINGL, __ATOMIC_RELEASE); //Free the slot for the next lap
+		tail++;
+
+		if(neo_vcd_lens[cur] > VCDBUFL - 64) cur = __neo_vcd_swap(cur);
+	}
+
+	pthread_mutex_lock(&neo_vcd_lock);
+	neo_vcd_quit = 1;
+	pthread_cond_signal(&neo_vcd_ready);
+	pthread_mutex_unlock(&neo_vcd_lock);
+	return NULL;
+}
+
+#endif
+
+/**
+ * @brief Starts recording pin activity to a VCD file
+ * 
+ * Every write to the recorded pins (neo_gpio_digital_write, neo_gpio_write_mask, the fake pwm
+ * and anything else writing them) and every edge the interrupt engine sees on them is streamed to path.
+ * Only interrupt attached pins have their inputs recorded. The file is overwritten
+ * 
+ * @return NEO_OK, NEO_FAIL if already recording or NEO_PIN_ERROR/NEO_EXPORT_ERROR if the pins or the file are wrong
+ * @param path The VCD file to write
+ * @param pins The pins to record (bit n is gpio pin n)
+ *
+ * @note Call neo_vcd_stop() to get a complete file, the file is only flushed every few milliseconds
+ */
+int neo_vcd_start(const char *path, uint64_t pins) {
+	char head[VCDBUFL];
+	int pin, len, ind;
+
+	if(neo_vcd_fd >= 0) return NEO_FAIL;
+	if(path == NULL) return NEO_EXPORT_ERROR;
+	if(pins == 0 || (pins >> GPIOPORTSL)) return NEO_PIN_ERROR;
+
+	neo_vcd_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if(neo_vcd_fd < 0) return NEO_EXPORT_ERROR;
+
+	//One wire per pin, starting unknown
+	len = sprintf(head, "$version libneo $end\n$timescale 1ns $end\n$scope module neo $end\n");
+	for(pin = 0; pin < GPIOPORTSL; pin++) {
+		if((pins >> pin) & 1ULL) len += sprintf(head + len, "$var wire 1 %c gpio%d $end\n", VCDID(pin), pin);
+	}
+	len += sprintf(head + len, "$upscope $end\n$enddefinitions $end\n#0\n$dumpvars\n");
+	for(pin = 0; pin < GPIOPORTSL; pin++) {
+		if((pins >> pin) & 1ULL) len += sprintf(head + len, "x%c\n", VCDID(pin));
+	}
+	len += sprintf(head + len, "$end\n");
+
+	if(write(neo_vcd_fd, head, len) != len) {
+		close(neo_vcd_fd);
+		neo_vcd_fd = -1;
+		return NEO_EXPORT_ERROR;
+	}
+
+	//Every slot starts free for the first lap
+	for(ind = 0; ind < VCDRINGL; ind++) neo_vcd_ring[ind].seq = ind;
+	neo_vcd_head = neo_vcd_tail = neo_vcd_dropped = 0;
+	neo_vcd_pending = -1;
+	neo_vcd_quit = 0;
+	neo_vcd_start_ns = __neo_vcd_now();
+	neo_vcd_running = 1;
+
+	if(pthread_create(&neo_vcd_io_thread, NULL, __neo_vcd_io_loop, NULL) != 0) {
+		close(neo_vcd_fd);
+		neo_vcd_fd = -1;
+		return NEO_FAIL;
+	}
+	if(pthread_create(&neo_vcd_drain_thread, NULL, __neo_vcd_drain_loop, NULL) != 0) {
+		pthread_mutex_lock(&neo_vcd_lock);
+		neo_vcd_quit = 1;
+		pthread_cond_signal(&neo_vcd_ready);
+		pthread_mutex_unlock(&neo_vcd_lock);
+		pthread_join(neo_vcd_io_thread, NULL);
+		close(neo_vcd_fd);
+		neo_vcd_fd = -1;
+		return NEO_FAIL;
+	}
+
+	__atomic_store_n(&neo_vcd_pins, pins, __ATOMIC_RELEASE); //Start taking events
+	return NEO_OK;
+}
+
+/**
+ * @brief Stops recording and completes the VCD file
+ * 
+ * Everything recorded so far is written before this returns
+ * 
+ * @return NEO_OK or NEO_FAIL if nothing was being recorded
+ * @param dropped Where to store the amount of changes that didn't fit in the ring (can be NULL)
+ */
+int neo_vcd_stop(uint64_t *dropped) {
+	if(neo_vcd_fd < 0) return NEO_FAIL;
+
+	__atomic_store_n(&neo_vcd_pins, 0, __ATOMIC_RELEASE);
+	__atomic_store_n(&neo_vcd_running, 0, __ATOMIC_RELEASE); //The drain thread empties the ring then quits
+
+	pthread_join(neo_vcd_drain_thread, NULL);
+	pthread_join(neo_vcd_io_thread, NULL);
+	close(neo_vcd_fd);
+	neo_vcd_fd = -1;
+
+	if(dropped != NULL) *dropped = __atomic_load_n(&neo_vcd_dropped, __ATOMIC_RELAXED);
+	return NEO_OK;
+}
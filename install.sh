@@ -3,7 +3,7 @@
 echo "Welcome to the quick and easy NEOC installer by David Smerkous"
 
 echo "Double checking requirements"
-sudo apt-get install build-essential doxygen git pkg-config glib2.0
+sudo apt-get install build-essential doxygen git
 echo "DONE!"
 
 echo "Downloading repository..."